@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "generic/line_buffer.h"
+#include "generic/output.h"
+#include "generic/parallel.h"
+#include "generic/source.h"
+#include "generic/translator.h"
+#include "generic/utils.h"
+#include "hack/asm/builder.h"
+#include "hack/jack/builder.h"
+#include "hack/jack/grammar.h"
+#include "hack/jack/symbol_table.h"
+#include "hack/jack/tokenizer.h"
+#include "hack/vm/builder.h"
+
+#include "./generators.h"
+
+using Clock = std::chrono::steady_clock;
+
+void usage(char *exec) {
+  std::cout << "Usage:\n" << exec
+            << " [--max-lines=N] [--repeat=N] [-o FILE] [NAME...]\n"
+            << "  --max-lines=N  largest input to try, 100000 by default (up to\n"
+            << "                 1000000 works, but takes a while); sizes go\n"
+            << "                 up from 1000 by 10x\n"
+            << "  --repeat=N     runs per benchmark and size, the fastest\n"
+            << "                 one counts (3 by default)\n"
+            << "  -o FILE        write the JSON results to FILE, not stdout\n"
+            << "  NAME...        only run the benchmarks with these names\n";
+}
+
+struct Result {
+  std::string name;
+  std::string kind;    // "micro": one component, "macro": text to text
+  size_t lines;        // input lines
+  size_t bytes;        // input bytes
+  size_t outputs;      // whatever the benchmark produces, as a check
+  double best;         // seconds
+  double mean;
+};
+
+// hands out tokens read up front, so parsing is measured on its own.
+class ReplayTokenizer: public JackTokenizer {
+public:
+  ReplayTokenizer(const std::vector<Token> &tokens)
+    : JackTokenizer(noLines), _tokens(tokens), _next(0) { }
+  virtual bool hasMore() override { return _next < _tokens.size(); }
+  virtual void advance() override { ++_next; }
+  virtual Token getCurrentToken() override { return _tokens[_next]; }
+  virtual void rewind() override { _next = 0; }
+private:
+  static const LineIndex noLines;
+  const std::vector<Token> &_tokens;
+  size_t _next;
+};
+
+const LineIndex ReplayTokenizer::noLines;
+
+// the asm generator keeps programs small enough to assemble.
+static std::vector<std::string> asmPrograms(size_t lines) {
+  std::vector<std::string> programs;
+  for (size_t done = 0; done < lines; done += ASM_PROGRAM_LINES)
+    programs.push_back(generateAsm(std::min(ASM_PROGRAM_LINES, lines - done),
+                                   programs.size() + 1));
+  return programs;
+}
+
+static std::vector<LineIndex> indexAll(const std::vector<std::string> &texts) {
+  std::vector<LineIndex> indexes(texts.size());
+  for (size_t i = 0; i < texts.size(); ++i)
+    indexLines(indexes[i], texts[i]);
+  return indexes;
+}
+
+static size_t totalSize(const std::vector<std::string> &texts) {
+  size_t size = 0;
+  for (const std::string &text: texts)
+    size += text.size();
+  return size;
+}
+
+class Bench {
+public:
+  Bench(int repeat, const std::vector<std::string> &only)
+    : _repeat(repeat), _only(only) { }
+
+  // runs fn _repeat times, fn returns how much output it made.
+  void run(const std::string &name, const std::string &kind, size_t lines,
+           size_t bytes, const std::function<size_t()> &fn) {
+    if (!_only.empty() &&
+        std::find(_only.begin(), _only.end(), name) == _only.end())
+      return;
+    Result result {name, kind, lines, bytes, 0, 0, 0};
+    double total = 0;
+    for (int i = 0; i < _repeat; ++i) {
+      Clock::time_point start = Clock::now();
+      result.outputs = fn();
+      double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      result.best = i ? std::min(result.best, seconds) : seconds;
+      total += seconds;
+    }
+    result.mean = total / _repeat;
+    std::cerr << name << ' ' << lines << " lines: "
+              << result.best * 1e3 << " ms\n";
+    _results.push_back(result);
+  }
+
+  bool wants(const std::vector<std::string> &names) const {
+    if (_only.empty())
+      return true;
+    for (const std::string &name: names)
+      if (std::find(_only.begin(), _only.end(), name) != _only.end())
+        return true;
+    return false;
+  }
+
+  std::string json() const {
+    char buf[64];
+    std::string out = "{\n  \"version\": \"" HCC_VERSION "\",\n";
+    out += withNumber("  \"repeat\": ", _repeat) + ",\n  \"results\": [\n";
+    for (size_t i = 0; i < _results.size(); ++i) {
+      const Result &r = _results[i];
+      out += "    {\"name\": \"" + r.name + "\", \"kind\": \"" + r.kind + "\"";
+      out += withNumber(", \"lines\": ", r.lines);
+      out += withNumber(", \"bytes\": ", r.bytes);
+      out += withNumber(", \"outputs\": ", r.outputs);
+      std::snprintf(buf, sizeof(buf), ", \"best_s\": %.6f, \"mean_s\": %.6f",
+                    r.best, r.mean);
+      out += buf;
+      double best = r.best > 0 ? r.best : 1e-9;
+      std::snprintf(buf, sizeof(buf), ", \"lines_per_s\": %.0f, \"mb_per_s\": %.2f}",
+                    r.lines / best, r.bytes / best / 1e6);
+      out += buf;
+      out += i + 1 < _results.size() ? ",\n" : "\n";
+    }
+    return out + "  ]\n}\n";
+  }
+private:
+  int _repeat;
+  std::vector<std::string> _only;
+  std::vector<Result> _results;
+};
+
+static void benchJack(Bench &bench, size_t lines) {
+  if (!bench.wants({"jack_tokenize", "jack_parse", "jack_codegen", "jack_to_vm"}))
+    return;
+  std::string text = generateJack(lines);
+  LineIndex index;
+  indexLines(index, text);
+
+  bench.run("jack_tokenize", "micro", lines, text.size(), [&] {
+    JackTokenizer tokenizer(index);
+    size_t tokens = 0;
+    for (; tokenizer.hasMore(); tokenizer.advance())
+      ++tokens;
+    return tokens;
+  });
+
+  std::vector<Token> tokens;
+  JackTokenizer tokenizer(index);
+  for (; tokenizer.hasMore(); tokenizer.advance())
+    tokens.push_back(tokenizer.getCurrentToken());
+  bench.run("jack_parse", "micro", lines, text.size(), [&] {
+    ReplayTokenizer replay(tokens);
+    JackCompilationEngineBuilder builder;
+    return builder.buildClass(replay).getSubroutineDecs().size();
+  });
+
+  ReplayTokenizer replay(tokens);
+  ClassElement classElement = JackCompilationEngineBuilder().buildClass(replay);
+  bench.run("jack_codegen", "micro", lines, text.size(), [&] {
+    SymbolTable symbolTable;
+    return classElement.toVMCode(symbolTable).size();
+  });
+
+  bench.run("jack_to_vm", "macro", lines, text.size(), [&] {
+    LineIndex lineIndex;
+    indexLines(lineIndex, text);
+    JackTokenizer tokenizer(lineIndex);
+    JackCompilationEngineBuilder builder;
+    ClassElement parsed = builder.buildClass(tokenizer);
+    SymbolTable symbolTable;
+    LineBuffer out;
+    for (const std::string &line: parsed.toVMCode(symbolTable))
+      out.push_back(line);
+    return out.size();
+  });
+}
+
+static void benchVM(Bench &bench, size_t lines) {
+  if (!bench.wants({"vm_translate", "vm_to_asm"}))
+    return;
+  std::string text = generateVM(lines);
+  LineIndex index;
+  indexLines(index, text);
+  bench.run("vm_translate", "micro", lines, text.size(), [&] {
+    HackBuilderVMTranslator builder("Bench.vm");
+    return runBuilders({&builder}, index, "Bench.vm").size();
+  });
+
+  bench.run("vm_to_asm", "macro", lines, text.size(), [&] {
+    LineIndex index;
+    indexLines(index, text);
+    HackBuilderVMTranslator builder("Bench.vm");
+    return runBuilders({&builder}, index, "Bench.vm").size();
+  });
+}
+
+static void benchAsm(Bench &bench, size_t lines) {
+  if (!bench.wants({"asm_assemble", "asm_assemble_parallel", "asm_to_hack"}))
+    return;
+  std::vector<std::string> programs = asmPrograms(lines);
+  std::vector<LineIndex> indexes = indexAll(programs);
+  size_t bytes = totalSize(programs);
+
+  // "-" keeps the assembler from writing an .asm_debug file.
+  bench.run("asm_assemble", "micro", lines, bytes, [&] {
+    size_t out = 0;
+    for (const LineIndex &index: indexes) {
+      HackAssembler assembler("-");
+      out += runBuilders({&assembler}, index, "-").size();
+    }
+    return out;
+  });
+
+  // the same, with each program split over every core.
+  bench.run("asm_assemble_parallel", "micro", lines, bytes, [&] {
+    size_t out = 0;
+    for (const LineIndex &index: indexes) {
+      HackAssembler assembler("-");
+      assembler.setJobs(hardwareJobs());
+      out += runBuilders({&assembler}, index, "-").size();
+    }
+    return out;
+  });
+
+  bench.run("asm_to_hack", "macro", lines, bytes, [&] {
+    size_t out = 0;
+    for (const std::string &program: programs) {
+      LineIndex index;
+      indexLines(index, program);
+      HackAssembler assembler("-");
+      out += runBuilders({&assembler}, index, "-").size();
+    }
+    return out;
+  });
+}
+
+int main(int argc, char **argv) {
+  size_t maxLines = 100000;
+  int repeat = 3;
+  std::string outputFile = "-";
+  std::vector<std::string> only;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    ParsedNumber n = parseNumber(arg.substr(arg.find('=') + 1), 1);
+    if (startsWith(arg, "--max-lines=") && n.ok()) {
+      maxLines = n.value;
+    } else if (startsWith(arg, "--repeat=") && n.ok()) {
+      repeat = n.value;
+    } else if (arg == "-o" && i + 1 < argc) {
+      outputFile = argv[++i];
+    } else if (!arg.empty() && arg.front() != '-') {
+      only.push_back(arg);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  Bench bench(repeat, only);
+  try {
+    for (size_t lines = 1000; lines <= maxLines; lines *= 10) {
+      benchJack(bench, lines);
+      benchVM(bench, lines);
+      benchAsm(bench, lines);
+    }
+    OutputSink out(outputFile);
+    out.write(bench.json());
+    out.close();
+  } catch (std::runtime_error &e) {
+    std::cerr << e.what();
+    return 1;
+  }
+  return 0;
+}
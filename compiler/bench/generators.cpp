@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "generic/utils.h"
+
+#include "./generators.h"
+
+// tiny LCG; std distributions differ between standard libraries,
+// this gives the same numbers everywhere.
+class Random {
+public:
+  Random(unsigned seed): _state(seed * 2654435761u + 1) { }
+  // in [0, n)
+  int next(int n) {
+    _state = _state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<int>((_state >> 33) % n);
+  }
+private:
+  uint64_t _state;
+};
+
+// adds lines that don't do anything until there are `lines` of them.
+static void pad(std::string &out, size_t &count, size_t lines,
+                const std::string &comment) {
+  for (; count < lines; ++count)
+    out += comment + "\n";
+}
+
+// Jack
+
+static std::string jackStatement(Random &random, int function) {
+  std::string k = withNumber("", random.next(1000));
+  switch (random.next(10)) {
+    case 0: return "let x = x + " + k + ";";
+    case 1: return "let y = (x * " + k + ") - (y / " +
+                   withNumber("", random.next(9) + 1) + ");";
+    case 2: return "if (x > " + k + ") { let x = x - 1; } else { let y = y + a; }";
+    case 3: return "while (i < " + k + ") { let i = i + 1; let total = total + i; }";
+    case 4: return "do Output.printInt(x + y);";
+    case 5: return "let arr[i] = (x & " + k + ") | (~y);";
+    case 6: return "let s = \"bench " + k + "\";";
+    case 7: return withNumber("let x = Bench.f", random.next(function + 1)) + "(x, y);";
+    case 8: return "let y = s.length() + arr[" + k + "];";
+    default: return "/* negate */ let b = -a; // and again";
+  }
+}
+
+std::string generateJack(size_t lines, unsigned seed) {
+  Random random(seed);
+  std::string out = "class Bench {\n  static int total;\n";
+  size_t count = 2;
+  // header, 3 var lines, return and closing brace around the body.
+  constexpr size_t FUNCTION_LINES = 6;
+  // the class' closing brace is the last line.
+  for (int function = 0; count + FUNCTION_LINES + 2 <= lines; ++function) {
+    size_t body = std::min<size_t>(lines - 1 - count - FUNCTION_LINES,
+                                   1 + random.next(30));
+    out += withNumber("  function int f", function) + "(int a, int b) {\n";
+    out += "    var int x, y, i;\n";
+    out += "    var Array arr;\n";
+    out += "    var String s;\n";
+    for (size_t i = 0; i < body; ++i)
+      out += "    " + jackStatement(random, function) + "\n";
+    out += "    return x + y;\n";
+    out += "  }\n";
+    count += FUNCTION_LINES + body;
+  }
+  pad(out, count, lines - 1, "  // padding");
+  out += "}\n";
+  return out;
+}
+
+// VM
+
+static std::string vmStatement(Random &random, int function) {
+  std::string k = withNumber("", random.next(1000));
+  std::string local = withNumber("local ", random.next(3));
+  switch (random.next(7)) {
+    case 0: return "push constant " + k + "\npush " + local + "\nadd\npop local 1";
+    case 1: return "push local 1\npush constant " + k + "\nlt\nif-goto LOOP";
+    case 2: return withNumber("push static ", random.next(16)) +
+                   "\npush argument 1\neq\n" +
+                   withNumber("pop static ", random.next(16));
+    case 3: return "push constant " + k + "\npop pointer 1\npush that 0\n" +
+                   withNumber("pop temp ", random.next(8));
+    case 4: return "push local 0\npush local 1\n" +
+                   withNumber("call Bench.f", random.next(function + 1)) +
+                   " 2\npop " + local;
+    case 5: return withNumber("push this ", random.next(8)) + "\nneg\nnot\n" +
+                   withNumber("pop that ", random.next(8));
+    default: return "push " + local + "\npush constant " + k + "\ngt\nif-goto END";
+  }
+}
+
+std::string generateVM(size_t lines, unsigned seed) {
+  Random random(seed);
+  std::string out;
+  size_t count = 0;
+  // function, label LOOP, label END, push and return.
+  constexpr size_t FUNCTION_LINES = 5;
+  constexpr size_t STATEMENT_LINES = 4;
+  for (int function = 0; count + FUNCTION_LINES + STATEMENT_LINES <= lines; ++function) {
+    size_t statements = std::min<size_t>(
+      (lines - count - FUNCTION_LINES) / STATEMENT_LINES, 1 + random.next(20));
+    out += withNumber("function Bench.f", function) + " 3\n";
+    out += "label LOOP\n";
+    for (size_t i = 0; i < statements; ++i)
+      out += vmStatement(random, function) + "\n";
+    out += "label END\npush local 0\nreturn\n";
+    count += FUNCTION_LINES + statements * STATEMENT_LINES;
+  }
+  pad(out, count, lines, "// padding");
+  return out;
+}
+
+// asm
+
+// every block is this many lines long, after its LOOP_ label.
+constexpr size_t ASM_BLOCK_LINES = 6;
+
+static std::string asmBlock(Random &random, int block) {
+  std::string var = withNumber("@v", random.next(64));
+  std::string k = withNumber("@", random.next(32768));
+  switch (random.next(5)) {
+    case 0: return var + "\nD=M\n" + k + "\nD=D+A\n" + var + "\nM=D";
+    // label defined further down
+    case 1: return withNumber("@SKIP_", block) + "\nD;JGT\n" + var +
+                   "\nM=M+1\n" + withNumber("(SKIP_", block) + ")\n// skipped";
+    case 2: return withNumber("@LOOP_", random.next(block + 1)) +
+                   "\nD;JEQ\n@SP\nAM=M-1\nD=M\nA=A-1";
+    case 3: return "@R13\nM=D\n@SCREEN\nD=A\n@KBD\nD=D&M    // keyboard";
+    default: return var + "\nMD=M-1\n@THIS\nA=M\nAMD=D|M\n0;JMP";
+  }
+}
+
+std::string generateAsm(size_t lines, unsigned seed) {
+  Random random(seed);
+  std::string out;
+  size_t count = 0;
+  for (int block = 0; count + 1 + ASM_BLOCK_LINES <= lines; ++block) {
+    out += withNumber("(LOOP_", block) + ")\n";
+    out += asmBlock(random, block) + "\n";
+    count += 1 + ASM_BLOCK_LINES;
+  }
+  pad(out, count, lines, "// padding");
+  return out;
+}
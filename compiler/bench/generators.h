@@ -0,0 +1,22 @@
+#ifndef __BENCH__GENERATORS__H__
+#define __BENCH__GENERATORS__H__
+
+#include <cstddef>
+#include <string>
+
+// Synthetic inputs of exactly `lines` lines, each ending in '\n'. They
+// only depend on the arguments, so a given size is the same program
+// on every run and machine and timings stay comparable over time.
+
+// one class, Bench, made of functions over the usual statements.
+std::string generateJack(size_t lines, unsigned seed = 1);
+// functions in the style of what the jack compiler outputs.
+std::string generateVM(size_t lines, unsigned seed = 1);
+// a single asm program, keep it at most ASM_PROGRAM_LINES long.
+std::string generateAsm(size_t lines, unsigned seed = 1);
+
+// the assembler takes at most 32K instructions per program, so bigger
+// asm inputs are split into programs of this many lines.
+constexpr size_t ASM_PROGRAM_LINES = 16384;
+
+#endif
@@ -0,0 +1,55 @@
+#include <exception>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "batch.h"
+#include "parallel.h"
+#include "source.h"
+#include "utils.h"
+
+void readManifest(std::vector<std::string> &paths, const std::string &manifest) {
+  std::string dir = manifest.substr(0, manifest.rfind(PATHSEP) + 1);
+  SourceBuffer source(manifest);
+  for (std::string_view line : source.lines()) {
+    line = trim_view(line.substr(0, line.find('#')));
+    if (line.empty())
+      continue;
+    std::string path(line);
+    if (path.front() != PATHSEP && !dir.empty())
+      path = joinPaths(dir, path);
+    paths.push_back(path);
+  }
+}
+
+// projects don't share any output, so they're spread over the
+// workers whole, each translating its own files in order.
+int translateBatch(const std::vector<std::string> &paths, int jobs,
+                   const std::function<void(const std::string &path)> &translate) {
+  std::vector<std::string> errors(paths.size());
+  parallelFor(paths.size(), jobs, [&](int, size_t i) {
+    try {
+      translate(paths[i]);
+    } catch (std::exception &e) {
+      errors[i] = e.what();
+      // the ok line is for an empty error.
+      if (errors[i].empty())
+        errors[i] = "unknown error";
+    }
+  });
+
+  size_t failed = 0;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (errors[i].empty()) {
+      status() << "ok      " << paths[i] << '\n';
+      continue;
+    }
+    ++failed;
+    std::string error = rstrip_copy(errors[i], "\n");
+    status() << "FAILED  " << paths[i] << ": " << error << '\n';
+  }
+  status() << paths.size() - failed << " of " << paths.size()
+           << " projects translated\n";
+  return failed ? 1 : 0;
+}
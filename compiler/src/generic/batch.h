@@ -0,0 +1,20 @@
+#ifndef __BATCH__H__
+#define __BATCH__H__
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Adds the paths listed in manifest to paths, one per line; # starts a
+// comment and blank lines are skipped. Relative paths are relative to
+// the manifest itself.
+void readManifest(std::vector<std::string> &paths, const std::string &manifest);
+
+// Translates each path as its own project, up to jobs of them at once,
+// then prints an ok/FAILED line for each. A project failing, whatever
+// it throws, doesn't stop the others. Returns the exit code: 1 if any
+// project failed, 0 otherwise.
+int translateBatch(const std::vector<std::string> &paths, int jobs,
+                   const std::function<void(const std::string &path)> &translate);
+
+#endif
@@ -1,32 +1,29 @@
-#include <list>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <utility>
 
 #include "builder.h"
-#include "instruction.h"
 #include "utils.h"
 
 Builder::Builder()
-  : _filename(""), _function("") {
-  output = new std::list<std::string>;
-}
+  : _lines(nullptr), _filename(""), _function(""), _labelId(0) { }
 
 Builder::Builder(const std::string &filename): Builder() {
   _filename = filename;
 }
 
-Builder::~Builder() {
-  delete output;
-}
+Builder::~Builder() { }
 
-void Builder::setLines(const std::list<std::string> *lines) {
+void Builder::setLines(const LineIndex *lines) {
   _lines = lines;
 }
 
 void Builder::setInputFile(const std::string &inputFile) {
   _filename = inputFile;
+  _labelId = 0;
   setCurrentFunction("");
 }
 
@@ -35,40 +32,23 @@ void Builder::setCurrentFunction(const std::string &function) {
 }
 
 void Builder::reset() {
-  output->clear();
+  output.clear();
   setLines(nullptr);
   setInputFile("");
 }
 
-std::list<std::string>* Builder::getResult() {
+LineBuffer Builder::getResult() {
   processLines(_lines);
-  return output;
+  return std::move(output);
 }
 
-void Builder::processLines(const std::list<std::string> *lines) {
-  int lineNo = 1;
-  for (const auto &line: *lines) {
-    Instruction *instr = parseLine(line);
-    // this will cause visitInstruction() to get called, where
-    // you define in the Instruction subclass what the builder method's
-    // name is that gets called.
-    if (instr) {
-      if (!instr->isValid()) {
-        debug("Invalid line", line);
-        std::ostringstream oss;
-        oss << "Error parsing line: " << lineNo << '\n';
-        std::string msg = oss.str();
-        throw std::runtime_error(msg);
-      }
-      instr->accept(this);
-    }
-    delete instr;
-    ++lineNo;
-  }
+void Builder::invalidLine(std::string_view line, int lineNo) {
+  debug("Invalid line", line);
+  std::ostringstream oss;
+  oss << "Error parsing line: " << lineNo << '\n';
+  throw std::runtime_error(oss.str());
 }
 
-void Builder::visit(Instruction *i) { }
-
 std::string Builder::getFilename() const {
   return _filename;
 }
@@ -76,3 +56,11 @@ std::string Builder::getFilename() const {
 std::string Builder::getCurrentFunction() const {
   return _function;
 }
+
+int Builder::nextLabelId() {
+  return _labelId++;
+}
+
+Phase Builder::phase() const {
+  return Phase::CODEGEN;
+}
@@ -1,35 +1,79 @@
 #ifndef __BUILDER__H__
 #define __BUILDER__H__
 
-#include <list>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
 
-class Instruction;
+#include "line_buffer.h"
+#include "source.h"
+#include "stats.h"
 
 class Builder {
 public:
-  void setLines(const std::list<std::string> *lines);
+  void setLines(const LineIndex *lines);
   void setInputFile(const std::string &inputFile);
   void setCurrentFunction(const std::string &function);
   void reset();
-  virtual std::list<std::string> *getResult();
-  virtual void visit(Instruction*);
+  // hands over the output, leaving the builder empty.
+  virtual LineBuffer getResult();
   std::string getFilename() const;
   std::string getCurrentFunction() const;
+  // ids for labels generated during translation; they restart with
+  // every input file so its output doesn't depend on other files.
+  int nextLabelId();
+  // what --stats reports the builder's time under.
+  virtual Phase phase() const;
 
   virtual ~Builder();
 protected:
   Builder();
   Builder(const std::string&);  // abstract
-  virtual Instruction* parseLine(const std::string&) = 0;
-  virtual void processLines(const std::list<std::string>*);
+  virtual void processLines(const LineIndex*) = 0;
+  [[noreturn]] void invalidLine(std::string_view line, int lineNo);
 
 protected:
-  std::list<std::string> *output;
+  LineBuffer output;
 private:
-  const std::list<std::string> *_lines;
+  const LineIndex *_lines;
   std::string _filename;  // crt file we're into
   std::string _function;  // crt function we're into
+  int _labelId;
+};
+
+// Builder for a fixed set of instruction types, listed in Instructions:
+// a std::variant whose first type is std::monostate (a line with no
+// code). Derived::parseLine(line, instr) puts the instruction in instr
+// and Derived::visit(T*) is called for it with T known at compile time,
+// so there are no casts or virtual accept() calls per line.
+template <class Derived, class Instructions>
+class InstructionBuilder: public Builder {
+protected:
+  InstructionBuilder(): Builder() { }
+  InstructionBuilder(const std::string &filename): Builder(filename) { }
+
+  virtual void processLines(const LineIndex *lines) override {
+    Derived &self = static_cast<Derived&>(*this);
+    // the line given to parseLine is a view into the builder's input,
+    // and instructions only live until the next line is parsed, in
+    // the same slot, so they aren't allocated one by one. What they
+    // copy out of the line (set(), AInstruction::value()) still is.
+    Instructions instr;
+    int lineNo = 1;
+    for (std::string_view line: *lines) {
+      self.parseLine(line, instr);
+      std::visit([&](auto &i) {
+        using T = std::decay_t<decltype(i)>;
+        if constexpr (!std::is_same_v<T, std::monostate>) {
+          if (!i.isValid())
+            invalidLine(line, lineNo);
+          self.visit(&i);
+        }
+      }, instr);
+      ++lineNo;
+    }
+  }
 };
 
 #endif
@@ -0,0 +1,182 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#include "cache.h"
+#include "output.h"
+#include "source.h"
+#include "stats.h"
+#include "utils.h"
+
+#ifndef HCC_VERSION
+#define HCC_VERSION "unknown"
+#endif
+
+// 128-bit FNV-1a; not cryptographic, but wide enough that two inputs
+// colliding by accident isn't a concern.
+class Fnv128 {
+public:
+  void add(std::string_view data) {
+    for (unsigned char c: data) {
+      _hash ^= c;
+      _hash *= PRIME;
+    }
+  }
+  std::string hex() const {
+    char out[33];
+    std::snprintf(out, sizeof(out), "%016llx%016llx",
+                  static_cast<unsigned long long>(_hash >> 64),
+                  static_cast<unsigned long long>(_hash));
+    return out;
+  }
+private:
+  static constexpr unsigned __int128 PRIME =
+    (static_cast<unsigned __int128>(1) << 88) + 0x13b;
+  unsigned __int128 _hash =
+    (static_cast<unsigned __int128>(0x6c62272e07bb0142ULL) << 64) +
+    0x62b821756295c58dULL;
+};
+
+// a rebuilt tool may translate differently even under the same version,
+// so its binary's size and mtime are part of every key too; hashing the
+// whole binary would cost more than many hits save.
+static const std::string& toolId() {
+  static const std::string id = [] {
+    std::string id = HCC_VERSION;
+    struct stat s;
+    if (stat("/proc/self/exe", &s) == 0)
+      id += " " + std::to_string(s.st_size) + " " +
+            std::to_string(s.st_mtim.tv_sec) + "." +
+            std::to_string(s.st_mtim.tv_nsec);
+    return id;
+  }();
+  return id;
+}
+
+BuildCache::BuildCache(): _resident(true) { }
+
+BuildCache::BuildCache(const std::string &dir): _dir(dir), _resident(false) {
+  if (mkdir(_dir.c_str(), 0755) != 0 && errno != EEXIST)
+    throw std::runtime_error("Cannot create cache dir " + _dir + "\n");
+}
+
+void BuildCache::setResident(bool resident) {
+  _resident = resident || _dir.empty();
+}
+
+LineBuffer BuildCache::get(std::string_view input, const std::string &salt,
+                           const std::function<LineBuffer()> &translate) {
+  std::string k = key(input, salt);
+  LineBuffer lines;
+  if (_resident && loadResident(salt, k, lines)) {
+    Stats::count(Counter::CACHE_HITS);
+    return lines;
+  }
+  std::string entry = _dir.empty() ? "" : entryPath(k);
+  if (!entry.empty() && load(entry, lines)) {
+    Stats::count(Counter::CACHE_HITS);
+  } else {
+    Stats::count(Counter::CACHE_MISSES);
+    lines = translate();
+    if (!entry.empty())
+      store(entry, lines);
+  }
+  if (_resident)
+    storeResident(salt, k, lines);
+  return lines;
+}
+
+std::string BuildCache::salt(const std::string &stage, const std::string &path,
+                             const std::string &options) {
+  // '\0' can't be in any of them, so the parts can't run into each other.
+  return stage + '\0' + toolId() + '\0' + options + '\0' + getFilename(path);
+}
+
+std::string BuildCache::key(std::string_view input, const std::string &salt) {
+  Fnv128 hash;
+  hash.add(salt);
+  hash.add(std::string_view("\0", 1));
+  hash.add(input);
+  return hash.hex();
+}
+
+std::string BuildCache::entryPath(const std::string &key) {
+  // spread entries over 256 dirs, like git objects.
+  return joinPaths(joinPaths(_dir, key.substr(0, 2)), key.substr(2));
+}
+
+bool BuildCache::loadResident(const std::string &salt, const std::string &key,
+                              LineBuffer &out) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _memory.find(salt);
+  if (it == _memory.end() || it->second.key != key)
+    return false;
+  out.appendText(it->second.lines.text());
+  return true;
+}
+
+void BuildCache::storeResident(const std::string &salt, const std::string &key,
+                               const LineBuffer &lines) {
+  Resident entry;
+  entry.key = key;
+  entry.lines.appendText(lines.text());
+  std::lock_guard<std::mutex> lock(_mutex);
+  // an older version of the same file isn't coming back, most likely.
+  _memory[salt] = std::move(entry);
+}
+
+// the last line of every entry: the size and hash of the text before
+// it, so a truncated or damaged entry reads as a miss.
+static std::string trailer(std::string_view text) {
+  Fnv128 hash;
+  hash.add(text);
+  return "#hcc " + std::to_string(text.size()) + " " + hash.hex() + "\n";
+}
+
+bool BuildCache::load(const std::string &entry, LineBuffer &out) {
+  struct stat s;
+  if (stat(entry.c_str(), &s) != 0)
+    return false;
+  SourceBuffer cached(entry);
+  std::string_view text = cached.contents();
+  // entries are only ever renamed in whole, but don't trust a
+  // damaged one.
+  if (text.size() < 2 || text.back() != '\n')
+    return false;
+  size_t last = text.rfind('\n', text.size() - 2);
+  size_t start = last == std::string_view::npos ? 0 : last + 1;
+  std::string_view lines = text.substr(0, start);
+  if (text.substr(start) != trailer(lines))
+    return false;
+  out.appendText(lines);
+  return true;
+}
+
+void BuildCache::store(const std::string &entry, const LineBuffer &lines) {
+  static std::atomic<unsigned> tmpId(0);
+  std::string dir = entry.substr(0, entry.rfind(PATHSEP));
+  if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+    return;  // a cache that can't be written is just a slower build
+  std::string tmp = entry + ".tmp." + std::to_string(getpid()) + "." +
+                    std::to_string(tmpId++);
+  try {
+    OutputSink out(tmp);
+    out.writeNoCopy(lines.text());
+    out.write(trailer(lines.text()));
+    out.close();
+  } catch (std::runtime_error &e) {
+    unlink(tmp.c_str());
+    return;
+  }
+  if (std::rename(tmp.c_str(), entry.c_str()) != 0)
+    unlink(tmp.c_str());
+}
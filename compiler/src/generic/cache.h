@@ -0,0 +1,56 @@
+#ifndef __CACHE__H__
+#define __CACHE__H__
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "line_buffer.h"
+
+// On disk cache of per-file translations, shared between runs. An
+// entry is keyed by a hash of the input's contents plus a salt naming
+// what produced it: the stage, the file name (output can depend on
+// it), this tool's version and build, and any flag changing output.
+// Entries are written to a temp file and renamed, so several threads
+// or processes can share a cache. Each ends in a line with the size and
+// hash of the rest, so a truncated or damaged entry is a miss.
+//
+// A resident cache also keeps the latest entry of every file in memory,
+// so a process rebuilding over and over (--watch) only translates what
+// changed; without a dir it never touches the disk.
+class BuildCache {
+public:
+  BuildCache();  // memory only, always resident
+  BuildCache(const std::string &dir);
+  void setResident(bool resident);
+
+  // the cached output for input, or what translate() gives, which
+  // then gets stored.
+  LineBuffer get(std::string_view input, const std::string &salt,
+                 const std::function<LineBuffer()> &translate);
+  // salt for a stage (e.g. "jack-vm") of the file at path, made with
+  // options, the flags that change the output (e.g. "format=bin").
+  static std::string salt(const std::string &stage, const std::string &path,
+                          const std::string &options);
+private:
+  // in memory entries, by salt: the latest key and output for a file.
+  struct Resident {
+    std::string key;
+    LineBuffer lines;
+  };
+  static std::string key(std::string_view input, const std::string &salt);
+  std::string entryPath(const std::string &key);
+  bool loadResident(const std::string &salt, const std::string &key, LineBuffer &out);
+  void storeResident(const std::string &salt, const std::string &key, const LineBuffer &lines);
+  bool load(const std::string &entry, LineBuffer &out);
+  void store(const std::string &entry, const LineBuffer &lines);
+private:
+  std::string _dir;  // empty for memory only
+  bool _resident;
+  std::mutex _mutex;  // guards _memory
+  std::unordered_map<std::string, Resident> _memory;
+};
+
+#endif
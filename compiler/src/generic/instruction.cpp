@@ -1,20 +1,30 @@
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <utility>
 
 #include "instruction.h"
-#include "builder.h"
 
-Instruction::Instruction(std::string line): _line(line) {}
+Instruction::Instruction(std::string_view line): _line(line), _isOwned(false) {}
+
+Instruction::Instruction(const Instruction &other)
+  : _line(other._line), _owned(other._owned), _isOwned(other._isOwned) {
+  if (_isOwned)
+    _line = _owned;
+}
+
 Instruction::~Instruction() {}
 
 std::string Instruction::toString() const {
-  return _line;
+  return std::string(_line);
 }
 
-void Instruction::accept(Builder *builder) {
-  builder->visit(this);
+std::string_view Instruction::view() const {
+  return _line;
 }
 
 void Instruction::set(std::string line) {
-  _line = line;
+  _owned = std::move(line);
+  _line = _owned;
+  _isOwned = true;
 }
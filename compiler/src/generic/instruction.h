@@ -2,26 +2,28 @@
 #define __INSTRUCTION__H__
 
 #include <string>
-
-#include "builder.h"
+#include <string_view>
 
 class Instruction {
 public:
   std::string toString() const;
+  std::string_view view() const;
 
   virtual ~Instruction();
   virtual bool isValid() = 0;
   virtual std::string translate() = 0;
-
-  // visitor pattern. You should call a method like
-  // builder->visitMyInstructionType(this) on the builder
-  // in the new instruction subclasses you define.
-  virtual void accept(Builder *builder);
 protected:
-  Instruction(std::string);  // abstract
+  // doesn't copy the line, it has to outlive the instruction
+  // (builders pass views into their input), unless set() is
+  // used later on to replace it.
+  Instruction(std::string_view);  // abstract
+  Instruction(const Instruction&);
+  Instruction& operator=(const Instruction&) = delete;
   void set(std::string line);
 private:
-  std::string _line;
+  std::string_view _line;
+  std::string _owned;  // backs _line once the instruction got rewritten
+  bool _isOwned;
 };
 
 #endif
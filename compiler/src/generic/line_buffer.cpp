@@ -0,0 +1,105 @@
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "line_buffer.h"
+
+LineBuffer::LineBuffer() { }
+
+LineBuffer::LineBuffer(LineBuffer &&other)
+  : _text(std::move(other._text)), _starts(std::move(other._starts)) {
+  other.clear();
+}
+
+LineBuffer& LineBuffer::operator=(LineBuffer &&other) {
+  if (this != &other) {
+    _text = std::move(other._text);
+    _starts = std::move(other._starts);
+    other.clear();
+  }
+  return *this;
+}
+
+void LineBuffer::push_back(std::string_view line) {
+  size_t last = 0;
+  size_t next = 0;
+  while ((next = line.find('\n', last)) != std::string_view::npos) {
+    _starts.push_back(_text.size());
+    _text.append(line, last, next - last + 1);
+    last = next + 1;
+  }
+  _starts.push_back(_text.size());
+  _text.append(line, last, std::string_view::npos);
+  _text.push_back('\n');
+}
+
+void LineBuffer::append(const LineBuffer &other) {
+  size_t offset = _text.size();
+  _text.append(other._text);
+  _starts.reserve(_starts.size() + other._starts.size());
+  for (size_t start : other._starts)
+    _starts.push_back(offset + start);
+}
+
+void LineBuffer::appendText(std::string_view text) {
+  size_t offset = _text.size();
+  _text.append(text);
+  size_t start = 0;
+  while (start < text.size()) {
+    _starts.push_back(offset + start);
+    size_t end = text.find('\n', start);
+    if (end == std::string_view::npos) {
+      _text.push_back('\n');  // last line wasn't terminated
+      break;
+    }
+    start = end + 1;
+  }
+}
+
+void LineBuffer::prepend(const LineBuffer &other) {
+  size_t offset = other._text.size();
+  _text.insert(0, other._text);
+  for (size_t &start : _starts)
+    start += offset;
+  _starts.insert(_starts.begin(), other._starts.begin(), other._starts.end());
+}
+
+void LineBuffer::reserve(size_t bytes, size_t lines) {
+  _text.reserve(bytes);
+  _starts.reserve(lines);
+}
+
+char* LineBuffer::appendFixed(size_t count, size_t width) {
+  size_t offset = _text.size();
+  _text.resize(offset + count * (width + 1), '\n');
+  _starts.reserve(_starts.size() + count);
+  for (size_t i = 0; i < count; ++i)
+    _starts.push_back(offset + i * (width + 1));
+  return &_text[offset];
+}
+
+void LineBuffer::clear() {
+  _text.clear();
+  _starts.clear();
+}
+
+size_t LineBuffer::size() const { return _starts.size(); }
+
+bool LineBuffer::empty() const { return _starts.empty(); }
+
+std::string_view LineBuffer::operator[](size_t i) const {
+  size_t end = i + 1 < _starts.size() ? _starts[i + 1] : _text.size();
+  // without the '\n'
+  return std::string_view(_text).substr(_starts[i], end - _starts[i] - 1);
+}
+
+std::string_view LineBuffer::text() const { return _text; }
+
+LineIndex LineBuffer::index() const {
+  LineIndex lines;
+  lines.reserve(size());
+  for (size_t i = 0; i < size(); ++i)
+    lines.push_back((*this)[i]);
+  return lines;
+}
@@ -0,0 +1,49 @@
+#ifndef __LINE_BUFFER__H__
+#define __LINE_BUFFER__H__
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "source.h"
+
+// Append-only arena of lines: all the text lives in one contiguous
+// string (each line followed by '\n') plus the offsets where lines
+// start. Builders write their output here and hand it to the next
+// pass by moving it, so there's no per-line allocation or copying.
+class LineBuffer {
+public:
+  LineBuffer();
+  LineBuffer(LineBuffer&&);
+  LineBuffer& operator=(LineBuffer&&);
+  LineBuffer(const LineBuffer&) = delete;
+  LineBuffer& operator=(const LineBuffer&) = delete;
+
+  // text containing '\n' gets stored as several lines.
+  void push_back(std::string_view line);
+  void append(const LineBuffer &other);
+  // text as given by text(): whole lines, each ending in '\n'.
+  void appendText(std::string_view text);
+  // one memmove of the whole buffer, use sparingly.
+  void prepend(const LineBuffer &other);
+  // adds count lines of width chars each and returns where the first
+  // starts, line k at k * (width + 1); the caller fills them in, from
+  // several threads if it likes, as long as the slices don't overlap.
+  char* appendFixed(size_t count, size_t width);
+  void reserve(size_t bytes, size_t lines);
+  void clear();
+
+  size_t size() const;
+  bool empty() const;
+  std::string_view operator[](size_t i) const;
+  // the whole text, every line terminated by '\n'.
+  std::string_view text() const;
+  // views stay valid until the buffer is next modified.
+  LineIndex index() const;
+private:
+  std::string _text;
+  std::vector<size_t> _starts;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utility>
+
+#include "output.h"
+#include "stats.h"
+#include "trace.h"
+
+OutputSink::OutputSink(const std::string &path)
+  : _path(path), _fd(-1), _ownsFd(false) {
+  if (path == "-") {
+    _fd = STDOUT_FILENO;
+  } else {
+    _fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (_fd < 0)
+      throw std::runtime_error("Cannot open " + path + " for writing\n");
+    _ownsFd = true;
+  }
+  _buffer.reserve(BUFFER_SIZE);
+}
+
+OutputSink::~OutputSink() {
+  try {
+    close();
+  } catch (std::runtime_error &e) { }
+}
+
+void OutputSink::write(std::string_view text) {
+  _buffer.append(text);
+  if (_buffer.size() >= BUFFER_SIZE)
+    flush();
+}
+
+void OutputSink::writeNoCopy(std::string_view text) {
+  if (text.size() < NO_COPY_THRESHOLD) {
+    write(text);
+    return;
+  }
+  // whatever got copied so far has to go out before text.
+  sealBuffer();
+  queue(text.data(), text.size());
+}
+
+void OutputSink::flush() {
+  if (_fd < 0)
+    return;
+  sealBuffer();
+
+  size_t i = 0;
+  while (i < _queue.size()) {
+    int n = static_cast<int>(std::min<size_t>(_queue.size() - i, IOV_MAX));
+    ssize_t written = ::writev(_fd, &_queue[i], n);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error("Cannot write to " + _path + "\n");
+    }
+    // skip what got written, a partially written piece gets
+    // trimmed and retried.
+    while (written > 0) {
+      size_t len = _queue[i].iov_len;
+      if (static_cast<size_t>(written) >= len) {
+        written -= len;
+        ++i;
+      } else {
+        _queue[i].iov_base = static_cast<char*>(_queue[i].iov_base) + written;
+        _queue[i].iov_len -= written;
+        written = 0;
+      }
+    }
+  }
+
+  _queue.clear();
+  _sealed.clear();
+}
+
+void OutputSink::close() {
+  flush();
+  if (_ownsFd && _fd >= 0 && ::close(_fd) != 0) {
+    _fd = -1;
+    throw std::runtime_error("Cannot write to " + _path + "\n");
+  }
+  _fd = -1;
+}
+
+void OutputSink::queue(const char *data, size_t size) {
+  if (size == 0)
+    return;
+  struct iovec piece;
+  piece.iov_base = const_cast<char*>(data);
+  piece.iov_len = size;
+  _queue.push_back(piece);
+}
+
+void OutputSink::sealBuffer() {
+  if (_buffer.empty())
+    return;
+  _sealed.push_back(std::move(_buffer));
+  queue(_sealed.back().data(), _sealed.back().size());
+  _buffer = std::string();
+  _buffer.reserve(BUFFER_SIZE);
+}
+
+void writeLines(const LineBuffer &lines, const std::string &path) {
+  TraceSpan span("pass", phaseName(Phase::WRITE) + (" " + path));
+  PhaseTimer timer(Phase::WRITE);
+  Stats::count(Counter::LINES_OUT, lines.size());
+  Stats::addWork(Phase::WRITE, lines.text().size());
+  // the lines are one contiguous buffer already, so this goes out
+  // in a single write.
+  OutputSink out(path);
+  out.writeNoCopy(lines.text());
+  out.close();
+}
@@ -0,0 +1,52 @@
+#ifndef __OUTPUT__H__
+#define __OUTPUT__H__
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "line_buffer.h"
+
+// Writes output with as few syscalls as possible: small pieces are
+// gathered into a large buffer, big ones are queued by reference, and
+// everything goes out through writev. The path "-" means stdout.
+class OutputSink {
+public:
+  OutputSink(const std::string &path);
+  ~OutputSink();  // flushes, but can't report errors; call close().
+  OutputSink(const OutputSink&) = delete;
+  OutputSink& operator=(const OutputSink&) = delete;
+
+  // copies text into the buffer.
+  void write(std::string_view text);
+  // doesn't copy text, it must stay alive until the next flush().
+  void writeNoCopy(std::string_view text);
+  void flush();
+  void close();
+private:
+  void queue(const char *data, size_t size);
+  void sealBuffer();
+private:
+  std::string _path;
+  int _fd;
+  bool _ownsFd;
+  // bytes copied by write(), not yet queued
+  std::string _buffer;
+  // copied bytes already queued; a deque so they never move
+  std::deque<std::string> _sealed;
+  std::vector<struct iovec> _queue;
+
+  static constexpr size_t BUFFER_SIZE = 1 << 16;
+  // referencing big chunks is cheaper than copying them.
+  static constexpr size_t NO_COPY_THRESHOLD = BUFFER_SIZE / 4;
+};
+
+// writes all lines to path ("-" for stdout) at once, timed as the
+// write phase for --stats and --trace.
+void writeLines(const LineBuffer &lines, const std::string &path);
+
+#endif
@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "parallel.h"
+
+void parallelFor(size_t count, int jobs,
+                 const std::function<void(int worker, size_t i)> &fn) {
+  if (jobs <= 1 || count <= 1) {
+    for (size_t i = 0; i < count; ++i)
+      fn(0, i);
+    return;
+  }
+
+  int nThreads = static_cast<int>(std::min<size_t>(jobs, count));
+  std::atomic<size_t> next(0);
+  std::vector<std::exception_ptr> errors(count);
+
+  auto work = [&](int worker) {
+    size_t i;
+    while ((i = next++) < count) {
+      try {
+        fn(worker, i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int worker = 1; worker < nThreads; ++worker)
+    threads.emplace_back(work, worker);
+  work(0);  // calling thread is worker 0
+  for (std::thread &t : threads)
+    t.join();
+
+  for (std::exception_ptr &e : errors)
+    if (e)
+      std::rethrow_exception(e);
+}
+
+int hardwareJobs() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
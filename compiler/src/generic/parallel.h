@@ -0,0 +1,18 @@
+#ifndef __PARALLEL__H__
+#define __PARALLEL__H__
+
+#include <cstddef>
+#include <functional>
+
+// Calls fn(worker, i) for every i in [0, count) using up to `jobs`
+// threads; worker is in [0, jobs) and tells which thread runs the call,
+// so callers can keep per-thread state. With jobs <= 1 everything runs
+// in order on the calling thread. If any call throws, the exception of
+// the lowest i is rethrown once all threads are done.
+void parallelFor(size_t count, int jobs,
+                 const std::function<void(int worker, size_t i)> &fn);
+
+// number of threads the hardware can run at once, at least 1.
+int hardwareJobs();
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef __PIPELINE__H__
+#define __PIPELINE__H__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "queue.h"
+
+// Streams count items through three stages at once: read(i) on a
+// reader thread, translate(worker, i, item) on `jobs` worker threads
+// and write(i, result) on the calling thread, strictly in order of i.
+// The reader stays at most `window` items ahead of the writer, so the
+// memory used doesn't depend on count. If a stage throws, everything
+// stops and the first exception is rethrown.
+template <class Item, class Result>
+void pipeline(size_t count, int jobs, size_t window,
+              const std::function<Item(size_t i)> &read,
+              const std::function<Result(int worker, size_t i, Item &item)> &translate,
+              const std::function<void(size_t i, Result &result)> &write) {
+  jobs = std::max(1, jobs);
+  window = std::max<size_t>(window, 1);
+  BoundedQueue<std::pair<size_t, Item>> toTranslate(window);
+  BoundedQueue<std::pair<size_t, Result>> toWrite(window);
+
+  std::mutex mutex;  // guards the rest
+  std::condition_variable progress;
+  size_t written = 0;
+  std::exception_ptr error;
+  auto fail = [&] {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error)
+        error = std::current_exception();
+    }
+    progress.notify_all();
+    toTranslate.cancel();
+    toWrite.cancel();
+  };
+  auto failed = [&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<bool>(error);
+  };
+
+  std::thread reader([&] {
+    try {
+      for (size_t i = 0; i < count; ++i) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          progress.wait(lock, [&] { return i < written + window || error; });
+          if (error)
+            return;
+        }
+        if (!toTranslate.push({i, read(i)}))
+          return;
+      }
+      toTranslate.close();
+    } catch (...) {
+      fail();
+    }
+  });
+
+  std::atomic<int> running(jobs);
+  std::vector<std::thread> workers;
+  for (int worker = 0; worker < jobs; ++worker)
+    workers.emplace_back([&, worker] {
+      try {
+        std::pair<size_t, Item> item;
+        while (toTranslate.pop(item))
+          if (!toWrite.push({item.first, translate(worker, item.first, item.second)}))
+            break;
+      } catch (...) {
+        fail();
+      }
+      // the last one out lets the writer know nothing else is coming.
+      if (--running == 0)
+        toWrite.close();
+    });
+
+  // results arrive in any order, the ones ahead wait here.
+  std::map<size_t, Result> pending;
+  try {
+    std::pair<size_t, Result> result;
+    while (written < count && toWrite.pop(result)) {
+      pending.emplace(result.first, std::move(result.second));
+      for (auto it = pending.begin();
+           it != pending.end() && it->first == written;
+           it = pending.erase(it)) {
+        write(written, it->second);
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          ++written;
+        }
+        progress.notify_all();
+      }
+    }
+  } catch (...) {
+    fail();
+  }
+
+  reader.join();
+  for (std::thread &t: workers)
+    t.join();
+  if (failed())
+    std::rethrow_exception(error);
+}
+
+#endif
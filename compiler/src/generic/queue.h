@@ -0,0 +1,69 @@
+#ifndef __QUEUE__H__
+#define __QUEUE__H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// Fixed capacity FIFO between threads: push() waits while it's full,
+// pop() while it's empty. After close() pops drain what's left, then
+// fail; after cancel() both fail right away.
+template <class T>
+class BoundedQueue {
+public:
+  BoundedQueue(size_t capacity)
+    : _capacity(capacity ? capacity : 1), _closed(false), _cancelled(false) { }
+
+  // false if the item got dropped because the queue was closed.
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notFull.wait(lock, [&] {
+      return _items.size() < _capacity || _closed || _cancelled;
+    });
+    if (_closed || _cancelled)
+      return false;
+    _items.push_back(std::move(item));
+    _notEmpty.notify_one();
+    return true;
+  }
+
+  // false once there's nothing more to pop.
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _notEmpty.wait(lock, [&] {
+      return !_items.empty() || _closed || _cancelled;
+    });
+    if (_cancelled || _items.empty())
+      return false;
+    item = std::move(_items.front());
+    _items.pop_front();
+    _notFull.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closed = true;
+    _notFull.notify_all();
+    _notEmpty.notify_all();
+  }
+
+  void cancel() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cancelled = true;
+    _notFull.notify_all();
+    _notEmpty.notify_all();
+  }
+private:
+  std::mutex _mutex;
+  std::condition_variable _notFull;
+  std::condition_variable _notEmpty;
+  std::deque<T> _items;
+  size_t _capacity;
+  bool _closed;
+  bool _cancelled;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "source.h"
+#include "utils.h"
+
+SourceBuffer::SourceBuffer(const std::string &path)
+  : _data(nullptr), _size(0), _mapped(false), _indexed(false) {
+  load(path);
+}
+
+SourceBuffer::~SourceBuffer() {
+  if (_mapped)
+    munmap(const_cast<char*>(_data), _size);
+}
+
+std::string_view SourceBuffer::contents() const {
+  return std::string_view(_data, _size);
+}
+
+const LineIndex& SourceBuffer::lines() {
+  if (!_indexed) {
+    indexLines(_lines, contents());
+    _indexed = true;
+  }
+  return _lines;
+}
+
+void SourceBuffer::load(const std::string &path) {
+  if (isStdio(path)) {
+    _fallback.assign(std::istreambuf_iterator<char>(std::cin),
+                     std::istreambuf_iterator<char>());
+    _data = _fallback.data();
+    _size = _fallback.size();
+    return;
+  }
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Cannot open file " + path + "\n");
+
+  struct stat s;
+  if (fstat(fd, &s) == 0 && S_ISREG(s.st_mode) && s.st_size > 0) {
+    void *addr = mmap(nullptr, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      _data = static_cast<const char*>(addr);
+      _size = s.st_size;
+      _mapped = true;
+      // we only ever scan the file front to back.
+      madvise(addr, _size, MADV_SEQUENTIAL);
+    }
+  }
+  close(fd);
+
+  // empty files and anything that isn't a regular file get read
+  // the old fashioned way.
+  if (!_mapped) {
+    std::ifstream in(path, std::ios::binary);
+    _fallback.assign(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+    _data = _fallback.data();
+    _size = _fallback.size();
+  }
+}
+
+void indexLines(LineIndex &lines, std::string_view text) {
+  lines.clear();
+  lines.reserve(std::count(text.begin(), text.end(), '\n') + 1);
+  size_t last = 0;
+  size_t next = 0;
+  while ((next = text.find('\n', last)) != std::string_view::npos) {
+    lines.push_back(text.substr(last, next - last));
+    last = next + 1;
+  }
+  lines.push_back(text.substr(last));
+}
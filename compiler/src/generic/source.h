@@ -0,0 +1,40 @@
+#ifndef __SOURCE__H__
+#define __SOURCE__H__
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// views of each line in a source, without the trailing '\n'.
+using LineIndex = std::vector<std::string_view>;
+
+// Read-only contents of an input file, memory mapped when possible
+// so lines can be handed out as views without copying them.
+// The path "-" reads stdin.
+class SourceBuffer {
+public:
+  SourceBuffer(const std::string &path);
+  ~SourceBuffer();
+  SourceBuffer(const SourceBuffer&) = delete;
+  SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+  std::string_view contents() const;
+  // every line in the file, built once on first call.
+  const LineIndex& lines();
+private:
+  void load(const std::string &path);
+private:
+  const char *_data;
+  size_t _size;
+  bool _mapped;
+  std::string _fallback;  // used when the file cannot be mmap-ed
+  LineIndex _lines;
+  bool _indexed;
+};
+
+// splits text by '\n'; there's always a (possibly empty) line after
+// the last '\n', same as reading with std::getline until eof.
+void indexLines(LineIndex &lines, std::string_view text);
+
+#endif
@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sys/resource.h>
+
+#include "stats.h"
+
+using Clock = std::chrono::steady_clock;
+
+bool Stats::_enabled = false;
+Clock::time_point Stats::_start;
+std::atomic<uint64_t> Stats::_nanos[static_cast<int>(Phase::COUNT)];
+std::atomic<uint64_t> Stats::_work[static_cast<int>(Phase::COUNT)];
+std::atomic<uint64_t> Stats::_counters[static_cast<int>(Counter::COUNT)];
+std::atomic<uint64_t> Stats::_allocs[static_cast<int>(Phase::COUNT) + 1];
+std::atomic<uint64_t> Stats::_allocBytes[static_cast<int>(Phase::COUNT) + 1];
+std::atomic<uint64_t> Stats::_frees[static_cast<int>(Phase::COUNT) + 1];
+
+struct PhaseInfo {
+  const char *name;
+  const char *unit;
+};
+
+// same order as Phase
+static const PhaseInfo phases[] = {
+  {"read", "bytes"},
+  {"tokenize", "lines"},
+  {"parse", "tokens"},
+  {"codegen", "lines"},
+  {"assemble", "lines"},
+  {"write", "bytes"},
+};
+
+// same order as Counter
+static const char *counters[] = {
+  "files",
+  "lines in",
+  "lines out",
+  "tokens",
+  "instructions",
+  "labels",
+  "cache hits",
+  "cache misses",
+};
+
+// the timer running on this thread, if any.
+static thread_local PhaseTimer *crtTimer = nullptr;
+
+const char* phaseName(Phase phase) {
+  return phases[static_cast<int>(phase)].name;
+}
+
+void Stats::enable() {
+  _enabled = true;
+  _start = Clock::now();
+}
+
+void Stats::addTime(Phase phase, std::chrono::nanoseconds time) {
+  if (_enabled)
+    _nanos[static_cast<int>(phase)] += time.count();
+}
+
+// where allocations on this thread go: the running timer's phase,
+// or the slot after the last phase.
+static int allocSlot() {
+  return crtTimer ? static_cast<int>(crtTimer->phase())
+                  : static_cast<int>(Phase::COUNT);
+}
+
+void Stats::allocated(size_t bytes) {
+  if (!_enabled)
+    return;
+  int slot = allocSlot();
+  _allocs[slot].fetch_add(1, std::memory_order_relaxed);
+  _allocBytes[slot].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Stats::freed() {
+  if (_enabled)
+    _frees[allocSlot()].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::report(std::ostream &out) {
+  if (!_enabled)
+    return;
+  double wall = std::chrono::duration<double>(Clock::now() - _start).count();
+
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(3);
+  out << "phase            time (ms)         work      throughput\n";
+  for (int i = 0; i < static_cast<int>(Phase::COUNT); ++i) {
+    uint64_t nanos = _nanos[i];
+    uint64_t work = _work[i];
+    if (!nanos && !work)
+      continue;
+    double seconds = nanos / 1e9;
+    out << std::left << std::setw(14) << phases[i].name << std::right
+        << std::setw(12) << seconds * 1e3
+        << std::setw(13) << work << ' ' << std::left << std::setw(6)
+        << phases[i].unit << std::right;
+    if (seconds > 0)
+      out << std::setprecision(1) << std::setw(10)
+          << work / seconds / 1e6 << " M" << phases[i].unit << "/s"
+          << std::setprecision(3);
+    out << '\n';
+  }
+  out << std::left << std::setw(14) << "wall" << std::right
+      << std::setw(12) << wall * 1e3 << '\n';
+  out << "(phase times add up over all worker threads)\n";
+
+  for (int i = 0; i < static_cast<int>(Counter::COUNT); ++i)
+    if (_counters[i])
+      out << std::left << std::setw(14) << counters[i] << std::right
+          << std::setw(12) << _counters[i] << '\n';
+
+#ifdef HCC_ALLOC_STATS
+  out << "allocations      count          bytes        frees\n";
+  for (int i = 0; i <= static_cast<int>(Phase::COUNT); ++i) {
+    if (!_allocs[i] && !_frees[i])
+      continue;
+    const char *name = i < static_cast<int>(Phase::COUNT) ? phases[i].name : "other";
+    out << std::left << std::setw(14) << name << std::right
+        << std::setw(10) << _allocs[i] << std::setw(15) << _allocBytes[i]
+        << std::setw(13) << _frees[i] << '\n';
+  }
+  out << "(frees count in the phase that frees, not the one that allocated)\n";
+#endif
+
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+    // kilobytes on linux
+    out << std::left << std::setw(14) << "peak RSS" << std::right
+        << std::setw(12) << usage.ru_maxrss << " KB\n";
+  out.flags(flags);
+}
+
+// PhaseTimer
+
+PhaseTimer::PhaseTimer(Phase phase)
+  : _phase(phase), _active(Stats::enabled()), _elapsed(0), _parent(nullptr) {
+  if (!_active)
+    return;
+  Clock::time_point now = Clock::now();
+  _parent = crtTimer;
+  if (_parent)
+    _parent->pause(now);
+  crtTimer = this;
+  _started = now;
+}
+
+PhaseTimer::~PhaseTimer() {
+  if (!_active)
+    return;
+  Clock::time_point now = Clock::now();
+  pause(now);
+  Stats::addTime(_phase, _elapsed);
+  crtTimer = _parent;
+  if (_parent)
+    _parent->resume(now);
+}
+
+void PhaseTimer::pause(Clock::time_point now) {
+  _elapsed += now - _started;
+}
+
+void PhaseTimer::resume(Clock::time_point now) {
+  _started = now;
+}
+
+#ifdef HCC_ALLOC_STATS
+// Replacing these counts every allocation in the program, whatever
+// container or library it comes from. They live here so they're
+// linked in whenever stats are. Every form of new and delete is
+// replaced, aligned and nothrow ones too, so none goes uncounted and
+// news and deletes add up.
+
+void* operator new(size_t size) {
+  Stats::allocated(size);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+  Stats::allocated(size);
+  // posix_memalign wants at least the alignment of a pointer.
+  size_t alignment = std::max(static_cast<size_t>(align), sizeof(void*));
+  void *p;
+  if (posix_memalign(&p, alignment, size ? size : 1) == 0)
+    return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+  return ::operator new(size);
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+  return ::operator new(size, align);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return ::operator new(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+  try {
+    return ::operator new(size, align);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return ::operator new(size, std::nothrow);
+}
+
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+  return ::operator new(size, align, std::nothrow);
+}
+
+// memory from both malloc and posix_memalign goes back with free, so
+// every delete ends up here.
+void operator delete(void *p) noexcept {
+  if (!p)
+    return;
+  Stats::freed();
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete(void *p, std::align_val_t, const std::nothrow_t&) noexcept {
+  ::operator delete(p);
+}
+
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t&) noexcept {
+  ::operator delete(p);
+}
+#endif
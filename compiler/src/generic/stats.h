@@ -0,0 +1,90 @@
+#ifndef __STATS__H__
+#define __STATS__H__
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// stages a translation goes through, not every tool has all of them.
+enum class Phase {
+  READ,
+  TOKENIZE,
+  PARSE,
+  CODEGEN,
+  ASSEMBLE,
+  WRITE,
+  COUNT,  // keep last
+};
+
+// "read", "assemble", ...
+const char* phaseName(Phase phase);
+
+enum class Counter {
+  FILES,
+  LINES_IN,
+  LINES_OUT,
+  TOKENS,
+  INSTRUCTIONS,
+  LABELS,
+  CACHE_HITS,
+  CACHE_MISSES,
+  COUNT,  // keep last
+};
+
+// Process wide numbers for --stats. Everything is a no-op until
+// enable() is called, which has to happen before any worker starts.
+class Stats {
+public:
+  static void enable();
+  static bool enabled() { return _enabled; }
+  static void count(Counter counter, uint64_t n = 1) {
+    if (_enabled)
+      _counters[static_cast<int>(counter)] += n;
+  }
+  // how much a phase got through, what its throughput is measured in.
+  static void addWork(Phase phase, uint64_t n) {
+    if (_enabled)
+      _work[static_cast<int>(phase)] += n;
+  }
+  static void addTime(Phase phase, std::chrono::nanoseconds time);
+  // called by operator new/delete in builds with HCC_ALLOC_STATS, for
+  // the phase running on the calling thread.
+  static void allocated(size_t bytes);
+  static void freed();
+  static void report(std::ostream &out);
+private:
+  static bool _enabled;
+  static std::chrono::steady_clock::time_point _start;
+  static std::atomic<uint64_t> _nanos[static_cast<int>(Phase::COUNT)];
+  static std::atomic<uint64_t> _work[static_cast<int>(Phase::COUNT)];
+  static std::atomic<uint64_t> _counters[static_cast<int>(Counter::COUNT)];
+  // one more than the phases, for allocations outside of any
+  static std::atomic<uint64_t> _allocs[static_cast<int>(Phase::COUNT) + 1];
+  static std::atomic<uint64_t> _allocBytes[static_cast<int>(Phase::COUNT) + 1];
+  static std::atomic<uint64_t> _frees[static_cast<int>(Phase::COUNT) + 1];
+};
+
+// Adds the time it's alive to a phase. Timers nest per thread: while
+// an inner one runs the outer one is paused, so the tokenizer being
+// driven by the parser isn't counted as parsing too.
+class PhaseTimer {
+public:
+  PhaseTimer(Phase phase);
+  ~PhaseTimer();
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+  Phase phase() const { return _phase; }
+private:
+  void pause(std::chrono::steady_clock::time_point now);
+  void resume(std::chrono::steady_clock::time_point now);
+private:
+  Phase _phase;
+  bool _active;
+  std::chrono::steady_clock::time_point _started;
+  std::chrono::nanoseconds _elapsed;
+  PhaseTimer *_parent;
+};
+
+#endif
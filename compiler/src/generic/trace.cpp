@@ -0,0 +1,120 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "output.h"
+#include "trace.h"
+
+using Clock = std::chrono::steady_clock;
+
+bool Trace::_enabled = false;
+std::string Trace::_path;
+
+struct TraceEvent {
+  const char *category;
+  std::string name;
+  int tid;
+  Clock::time_point start;
+  Clock::duration duration;
+};
+
+static Clock::time_point traceStart;
+static std::mutex eventsMutex;
+static std::vector<TraceEvent> events;
+
+// small thread ids, in the order threads first trace something;
+// the main thread traces first, so it's 0 like worker 0 is.
+static std::atomic<int> nextTid(0);
+static thread_local int crtTid = -1;
+
+static int threadId() {
+  if (crtTid < 0)
+    crtTid = nextTid++;
+  return crtTid;
+}
+
+static std::string jsonString(std::string_view s) {
+  std::string out = "\"";
+  for (char c: s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      out += escaped;
+    } else {
+      out += c;
+    }
+  }
+  return out + "\"";
+}
+
+// microseconds since the trace started, what the format wants.
+static std::string micros(Clock::duration d) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.3f",
+                std::chrono::duration<double, std::micro>(d).count());
+  return buf;
+}
+
+void Trace::enable(const std::string &path) {
+  _enabled = true;
+  _path = path;
+  traceStart = Clock::now();
+  threadId();
+}
+
+void Trace::write() {
+  if (!_enabled)
+    return;
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  OutputSink out(_path);
+  out.write("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  // a comma before every record but the first, there may be no events.
+  const char *separator = "";
+  auto record = [&](const std::string &json) {
+    out.write(separator);
+    out.write(json);
+    separator = ",\n";
+  };
+  for (int tid = 0; tid < nextTid; ++tid)
+    record("{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, "
+           "\"tid\": " + std::to_string(tid) + ", \"args\": {\"name\": " +
+           jsonString(tid ? "thread " + std::to_string(tid) : "main") + "}}");
+  for (const TraceEvent &e: events)
+    record("{\"ph\": \"X\", \"pid\": 1, \"tid\": " +
+           std::to_string(e.tid) + ", \"cat\": " + jsonString(e.category) +
+           ", \"name\": " + jsonString(e.name) +
+           ", \"ts\": " + micros(e.start - traceStart) +
+           ", \"dur\": " + micros(e.duration) + "}");
+  out.write("\n");
+  out.write("]}\n");
+  out.close();
+}
+
+// TraceSpan
+
+TraceSpan::TraceSpan(const char *category, std::string name)
+  : _category(category), _name(std::move(name)) {
+  if (Trace::enabled())
+    _start = Clock::now();
+}
+
+TraceSpan::~TraceSpan() {
+  if (!Trace::enabled())
+    return;
+  Clock::time_point end = Clock::now();
+  TraceEvent e{ _category, std::move(_name), threadId(), _start, end - _start };
+  std::lock_guard<std::mutex> lock(eventsMutex);
+  events.push_back(std::move(e));
+}
+
+void TraceSpan::setName(std::string name) {
+  _name = std::move(name);
+}
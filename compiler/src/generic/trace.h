@@ -0,0 +1,37 @@
+#ifndef __TRACE__H__
+#define __TRACE__H__
+
+#include <chrono>
+#include <string>
+
+// Timeline of what ran when and on which thread, written as Chrome
+// trace events (chrome://tracing, ui.perfetto.dev) for --trace.
+// Everything is a no-op until enable() is called, which has to happen
+// before any worker starts.
+class Trace {
+public:
+  static void enable(const std::string &path);
+  static bool enabled() { return _enabled; }
+  // writes all the spans that ended so far to the file given.
+  static void write();
+private:
+  static bool _enabled;
+  static std::string _path;
+};
+
+// One complete event, from construction to destruction.
+class TraceSpan {
+public:
+  TraceSpan(const char *category, std::string name = "");
+  ~TraceSpan();
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+  // for when the name is only known after the span started.
+  void setName(std::string name);
+private:
+  const char *_category;
+  std::string _name;
+  std::chrono::steady_clock::time_point _start;
+};
+
+#endif
@@ -6,66 +6,165 @@
 // the original code (the "essence" of each program).
 
 #include <algorithm>
-#include <fstream>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <list>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "cache.h"
+#include "line_buffer.h"
+#include "output.h"
+#include "source.h"
+#include "stats.h"
+#include "trace.h"
 #include "translator.h"
 #include "utils.h"
 
+LineBuffer runBuilders(const std::list<Builder*> &builders,
+                       const LineIndex &lines, const std::string &path) {
+  // first builder reads the given lines (usually the mmap-ed file),
+  // every other builder gets a view over the output of the previous
+  // one, which it took over by move.
+  const LineIndex *crtLines = &lines;
+  LineIndex prevIndex;
+  LineBuffer output;
+  for (Builder *builder: builders) {
+    TraceSpan span("pass", phaseName(builder->phase()));
+    PhaseTimer timer(builder->phase());
+    Stats::addWork(builder->phase(), crtLines->size());
+    builder->reset();
+    builder->setLines(crtLines);
+    builder->setInputFile(path);
+    output = builder->getResult();
+    prevIndex = output.index();
+    crtLines = &prevIndex;
+  }
+  return output;
+}
+
+// Translator
+
 Translator::Translator(const std::string &path)
-    : _path(path) { }
+    : _path(path), _jobs(1), _saveTemps(false), _pipeline(false),
+      _cache(nullptr) { }
 
 Translator::~Translator() {
-  for (Builder *b: _builders)
-    delete b;
+  for (std::list<Builder*> &builders: _builders)
+    for (Builder *b: builders)
+      delete b;
+}
+
+void Translator::setJobs(int jobs) {
+  _jobs = jobs;
+}
+
+void Translator::setOutputFile(const std::string &path) {
+  _outputFile = path;
+}
+
+void Translator::setSaveTemps(bool saveTemps) {
+  _saveTemps = saveTemps;
+}
+
+void Translator::setCache(BuildCache *cache) {
+  _cache = cache;
+}
+
+void Translator::setPipeline(bool pipeline) {
+  _pipeline = pipeline;
+}
+
+void Translator::addLibrary(const std::string &path) {
+  _libraries.push_back(path);
+}
+
+void Translator::setMakeLibrary(const std::string &path) {
+  _makeLibrary = path;
+}
+
+void Translator::setFormat(const std::string &format) {
+  if (format != "text")
+    throw std::runtime_error("Unknown format " + format + ", only text is written here\n");
+}
+
+std::string Translator::resolveOutputFile() {
+  if (!_outputFile.empty())
+    return _outputFile;
+  // input from stdin is usually part of a pipe, so keep piping.
+  if (isStdio(_path))
+    return "-";
+  return getOutputFile();
+}
+
+void Translator::createWorkers(int workers) {
+  while (static_cast<int>(_builders.size()) < workers)
+    _builders.push_back(createBuilders());
+}
+
+const std::list<Builder*>& Translator::getBuilders(int worker) {
+  return _builders.at(worker);
 }
 
 void Translator::translate() {
-  std::list<std::string> *outputLines;
-  outputLines = translateFile(_path);
-  beforeWriteToFile(*outputLines);
-  writeToFile(*outputLines);
+  createWorkers(1);
+  LineBuffer outputLines = translateFile(_path);
+  beforeWriteToFile(outputLines);
+  writeToFile(outputLines);
 }
 
-std::list<std::string>* Translator::translateFile(const std::string &path) {
-  std::list<std::string> *crtLines, *initLines;
-  initLines = crtLines = splitLines(path);
-  for (Builder *builder: _builders) {
-    builder->reset();
-    builder->setLines(crtLines);
-    builder->setInputFile(path);
-    crtLines = builder->getResult();
-  }
-  delete initLines;
-  return crtLines;
+void Translator::watch() {
+  throw std::runtime_error("Watching isn't supported for " + _path + "\n");
 }
 
-void Translator::beforeWriteToFile(std::list<std::string> &lines) { }
+void Translator::rebuild(const std::vector<std::string>&) {
+  translate();
+}
 
-void Translator::writeToFile(const std::list<std::string> &lines) {
-  std::cout << "Translating " << _path << " into "
-            << getOutputFile() << "\n";
+LineBuffer Translator::translateFile(const std::string &path, int worker) {
+  TraceSpan fileSpan("file", path);
+  SourceBuffer source(path);
+  return translateSource(path, source, worker);
+}
 
-  std::ofstream out(getOutputFile());
-  if (!lines.empty())
-    for (const std::string &s: lines)
-      out << s << '\n';
-  out.close();
+LineBuffer Translator::translateSource(const std::string &path,
+                                       SourceBuffer &source, int worker) {
+  Stats::count(Counter::FILES);
+  Stats::addWork(Phase::READ, source.contents().size());
+  return cached(path, source.contents(), [&] {
+    const LineIndex *lines;
+    {
+      TraceSpan span("pass", phaseName(Phase::READ));
+      PhaseTimer timer(Phase::READ);
+      lines = &source.lines();
+    }
+    Stats::count(Counter::LINES_IN, lines->size());
+    return runBuilders(getBuilders(worker), *lines, path);
+  });
 }
 
-std::list<std::string>* Translator::splitLines(const std::string &path) {
-  std::ifstream in(path);
-  std::string line;
+std::string Translator::cacheStage() { return ""; }
 
-  auto lines = new std::list<std::string>;
-  while (in) {
-    std::getline(in, line);
-    lines->push_back(line);
-  }
-  in.close();
-  return lines;
+std::string Translator::cacheOptions() { return ""; }
+
+LineBuffer Translator::cached(const std::string &path, std::string_view input,
+                              const std::function<LineBuffer()> &translate) {
+  std::string stage = cacheStage();
+  if (!_cache || stage.empty())
+    return translate();
+  return _cache->get(input, BuildCache::salt(stage, path, cacheOptions()), translate);
+}
+
+void Translator::beforeWriteToFile(LineBuffer &) { }
+
+void Translator::writeToFile(const LineBuffer &lines) {
+  std::string outputFile = resolveOutputFile();
+  status() << "Translating " << _path << " into "
+           << outputFile << "\n";
+
+  writeLines(lines, outputFile);
 }
@@ -1,27 +1,91 @@
 #ifndef __TRANSLATOR_H__
 #define __TRANSLATOR_H__
 
+#include <functional>
 #include <string>
+#include <string_view>
 #include <list>
 #include <vector>
 
 #include "builder.h"
+#include "cache.h"
+#include "line_buffer.h"
+#include "source.h"
+
+// chains builders over lines already in memory, each one reading what
+// the one before wrote; path only names the input. Translators and
+// libhcc go through it for every file.
+LineBuffer runBuilders(const std::list<Builder*> &builders,
+                       const LineIndex &lines, const std::string &path);
 
 class Translator {
 public:
   virtual ~Translator();
   virtual void translate();
+  // translates, then again whenever an input changes, until killed.
+  virtual void watch();
+  // how many input files get translated at once.
+  void setJobs(int jobs);
+  // overrides the default output file, "-" for stdout.
+  void setOutputFile(const std::string &path);
+  // also write the files between stages, for tools with several.
+  void setSaveTemps(bool saveTemps);
+  // reuse translations of files that didn't change since a former run.
+  void setCache(BuildCache *cache);
+  // read, translate and write files at the same time, for tools that
+  // bundle many files into one output.
+  void setPipeline(bool pipeline);
+  // links the classes the program needs from this library (.hlib),
+  // for tools making a whole program; the first one added wins.
+  void addLibrary(const std::string &path);
+  // bundles the translated inputs into a library at path, instead
+  // of the usual output.
+  void setMakeLibrary(const std::string &path);
+  // how the output is written, for tools that have several ways;
+  // "text" is the only one by default.
+  virtual void setFormat(const std::string &format);
 protected:
   Translator(const std::string &path);  // abstract
-  std::list<std::string>* splitLines(const std::string&);
-  virtual void beforeWriteToFile(std::list<std::string>&);
-  void writeToFile(const std::list<std::string>&);
+  virtual void beforeWriteToFile(LineBuffer&);
+  // builds again after the given inputs changed (were written, added
+  // or removed); all of it by default, the cache skips the rest.
+  virtual void rebuild(const std::vector<std::string> &changed);
+  void writeToFile(const LineBuffer&);
 
-  virtual std::list<std::string>* translateFile(const std::string&);
+  // builders keep state while going through a file, so every
+  // worker thread gets its own set of them.
+  virtual std::list<Builder*> createBuilders() = 0;
+  void createWorkers(int workers);
+  const std::list<Builder*>& getBuilders(int worker);
+  virtual LineBuffer translateFile(const std::string&, int worker=0);
+  // same, for a file that was already read.
+  virtual LineBuffer translateSource(const std::string &path, SourceBuffer &source,
+                                     int worker=0);
   virtual std::string getOutputFile() = 0;
+  // names what a translator caches per file (e.g. "vm-asm"), empty
+  // when its output can't be cached.
+  virtual std::string cacheStage();
+  // the options that change what gets cached, as part of the cache
+  // keys; none by default. Options only changing how the whole output
+  // is written, like --format, don't belong here.
+  virtual std::string cacheOptions();
+  // translate() or its cached result for the file at path, if
+  // there's a cache and the translator can use it.
+  LineBuffer cached(const std::string &path, std::string_view input,
+                    const std::function<LineBuffer()> &translate);
+  // the output file actually used, after -o and stdin are considered.
+  std::string resolveOutputFile();
 protected:
   std::string _path;
-  std::list<Builder*> _builders;
+  std::string _outputFile;
+  int _jobs;
+  bool _saveTemps;
+  bool _pipeline;
+  std::vector<std::string> _libraries;
+  std::string _makeLibrary;
+  BuildCache *_cache;
+private:
+  std::vector<std::list<Builder*>> _builders;  // one list per worker
 };
 
 #endif
@@ -1,8 +1,10 @@
 #include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <deque>
 #include <dirent.h>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -14,36 +16,92 @@
 
 #include "utils.h"
 
-bool isNumber(const std::string &s) {
-  int i = 0;
-  if (s[i] == '-' || s[i] == '+')
+bool isNumber(std::string_view s) {
+  size_t i = 0;
+  if (!s.empty() && (s[i] == '-' || s[i] == '+'))
     i++;
   for (; i < s.size(); ++i)
-    if (!std::isdigit(s[i]))
+    if (!std::isdigit(static_cast<unsigned char>(s[i])))
       return false;
   return true;
 }
 
-int getNumber(const std::string &s) {
-  std::istringstream iss(s);
-  int res;
-  iss >> res;
-  if (iss.fail()) {
-    std::cout << "Couldn't convert " << s << " to number.\n";
-    throw "Couldn't convert.";
+ParsedNumber parseNumber(std::string_view s, int min, int max) {
+  // from_chars doesn't take a '+', but isNumber does.
+  if (s.size() > 1 && s.front() == '+' && s[1] != '-')
+    s.remove_prefix(1);
+  int value = 0;
+  const char *end = s.data() + s.size();
+  auto [ptr, ec] = std::from_chars(s.data(), end, value);
+  if (s.empty() || ec == std::errc::invalid_argument || ptr != end)
+    return {0, NumberError::INVALID};
+  if (ec == std::errc::result_out_of_range || value < min || value > max)
+    return {0, NumberError::OUT_OF_RANGE};
+  return {value, NumberError::OK};
+}
+
+const char* numberErrorName(NumberError error) {
+  switch (error) {
+    case NumberError::OK: return "ok";
+    case NumberError::INVALID: return "not a number";
+    case NumberError::OUT_OF_RANGE: return "number out of range";
   }
-  return res;
+  return "";
 }
 
-template <typename T>
-std::string toString(T n) {
-  std::ostringstream oss;
-  oss << n;
-  return oss.str();
+// digits of every number in 0..HACK_NUMBERS-1, built at compile time.
+struct DecimalTable {
+  char digits[HACK_NUMBERS][5];
+  unsigned char sizes[HACK_NUMBERS];
+};
+
+static constexpr DecimalTable makeDecimalTable() {
+  DecimalTable table {};
+  for (int n = 0; n < HACK_NUMBERS; ++n) {
+    char reversed[5] {};
+    int size = 0;
+    int rest = n;
+    do {
+      reversed[size++] = static_cast<char>('0' + rest % 10);
+      rest /= 10;
+    } while (rest);
+    for (int i = 0; i < size; ++i)
+      table.digits[n][i] = reversed[size - 1 - i];
+    table.sizes[n] = static_cast<unsigned char>(size);
+  }
+  return table;
+}
+
+static constexpr DecimalTable decimalTable = makeDecimalTable();
+
+std::string_view formatNumber(long long n, NumberBuffer &buf) {
+  if (n >= 0 && n < HACK_NUMBERS)
+    return std::string_view(decimalTable.digits[n], decimalTable.sizes[n]);
+
+  // written backwards from the end of buf.
+  char *end = buf + sizeof(buf);
+  char *p = end;
+  // unsigned, so the most negative number can be negated too.
+  unsigned long long rest = n < 0 ? 0ULL - static_cast<unsigned long long>(n)
+                                  : static_cast<unsigned long long>(n);
+  do {
+    *--p = static_cast<char>('0' + rest % 10);
+    rest /= 10;
+  } while (rest);
+  if (n < 0)
+    *--p = '-';
+  return std::string_view(p, end - p);
 }
 
-template std::string toString<int>(int);
-template std::string toString<char>(char);
+void appendNumber(std::string &out, long long n) {
+  NumberBuffer buf;
+  out.append(formatNumber(n, buf));
+}
+
+std::string withNumber(std::string text, long long n) {
+  appendNumber(text, n);
+  return text;
+}
 
 // filesystem stuff
 
@@ -87,7 +145,7 @@ std::string replaceExtension(const std::string &path, const std::string &newExt)
 }
 
 std::string getFilename(const std::string &path) {
-  std::string p = rstrip_copy(path, toString(PATHSEP));
+  std::string p = rstrip_copy(path, std::string(1, PATHSEP));
 
   std::string filename(
     // find right-most separator char using a reverse iterator,
@@ -118,7 +176,7 @@ std::string getStem(const std::string &path) {
 }
 
 std::string joinPaths(const std::string &path, const std::string &filename) {
-  std::string sep = toString(PATHSEP);
+  std::string sep(1, PATHSEP);
   return (
     rstrip_copy(path, sep) +
     sep +
@@ -158,6 +216,20 @@ PathType getPathType(const std::string &path) {
   }
 }
 
+bool isStdio(const std::string &path) {
+  return path == "-";
+}
+
+static std::ostream *statusStream = &std::cout;
+
+std::ostream& status() {
+  return *statusStream;
+}
+
+void statusToStderr() {
+  statusStream = &std::cerr;
+}
+
 // string manipulations
 
 void ltrim(std::string &s) {
@@ -165,7 +237,7 @@ void ltrim(std::string &s) {
     s.cbegin(),
     std::find_if(
       s.begin(), s.end(),
-      [](char ch) { return !std::isspace(ch); }
+      [](unsigned char ch) { return !std::isspace(ch); }
     )
   );
 }
@@ -174,7 +246,7 @@ void rtrim(std::string &s) {
   s.erase(
     std::find_if(
       s.rbegin(), s.rend(),
-      [](char ch) { return !std::isspace(ch); }
+      [](unsigned char ch) { return !std::isspace(ch); }
     ).base(),
     s.end()
   );
@@ -200,30 +272,21 @@ std::string trim_copy(std::string s) {
   return s;
 }
 
+std::string_view trim_view(std::string_view s) {
+  auto isSpace = [](unsigned char ch) { return std::isspace(ch); };
+  while (!s.empty() && isSpace(s.front()))
+    s.remove_prefix(1);
+  while (!s.empty() && isSpace(s.back()))
+    s.remove_suffix(1);
+  return s;
+}
+
 void lstrip(std::string &s, const std::string &chars) {
-  bool stripped = true;
-  while (stripped) {
-    stripped = false;
-    for (const int &c : chars) {
-      if (!s.empty() && s.front() == c) {
-        s.erase(0, 1);
-        stripped = true;
-      }
-    }
-  }
+  s.erase(0, s.size() - lstrip_view(s, chars).size());
 }
 
 void rstrip(std::string &s, const std::string &chars) {
-  bool stripped = true;
-  while (stripped) {
-    stripped = false;
-    for (const int &c : chars) {
-      if (!s.empty() && s.back() == c) {
-        s.erase(s.size() - 1);
-        stripped = true;
-      }
-    }
-  }
+  s.resize(rstrip_view(s, chars).size());
 }
 
 void strip(std::string &s, const std::string &chars) {
@@ -246,7 +309,21 @@ std::string strip_copy(std::string s, const std::string &chars) {
   return s;
 }
 
-bool startsWith(const std::string &str, const std::string &prefix) {
+std::string_view lstrip_view(std::string_view s, std::string_view chars) {
+  size_t start = s.find_first_not_of(chars);
+  return start == std::string_view::npos ? s.substr(s.size()) : s.substr(start);
+}
+
+std::string_view rstrip_view(std::string_view s, std::string_view chars) {
+  size_t end = s.find_last_not_of(chars);
+  return s.substr(0, end == std::string_view::npos ? 0 : end + 1);
+}
+
+std::string_view strip_view(std::string_view s, std::string_view chars) {
+  return rstrip_view(lstrip_view(s, chars), chars);
+}
+
+bool startsWith(std::string_view str, std::string_view prefix) {
   if (str.size() < prefix.size())
     return false;
   return prefix == str.substr(0, prefix.size());
@@ -269,42 +346,47 @@ std::string join(const ContainerT &parts, const std::string &delim) {
 
 template std::string join<std::vector<std::string>>(const std::vector<std::string>&, const std::string&);
 
+// parts can hold strings, or views into line to avoid copying.
 template <class ContainerT>
-void split(ContainerT &parts, const std::string &line, const std::string &substr) {
+void split(ContainerT &parts, std::string_view line, std::string_view substr) {
+  using Part = typename ContainerT::value_type;
   size_t last = 0;
   size_t next = 0;
-  while ((next = line.find(substr, last)) != std::string::npos) {
-    std::string match = line.substr(last, next - last);
+  while ((next = line.find(substr, last)) != std::string_view::npos) {
+    std::string_view match = line.substr(last, next - last);
     if (!match.empty())
-      parts.push_back(match);
+      parts.push_back(Part(match));
     last = next + substr.size();
   }
-  parts.push_back(line.substr(last, next - last));
+  parts.push_back(Part(line.substr(last)));
 }
 
-template void split<std::vector<std::string>>(std::vector<std::string>&, const std::string&, const std::string&);
+template void split<std::vector<std::string>>(std::vector<std::string>&, std::string_view, std::string_view);
+template void split<std::vector<std::string_view>>(std::vector<std::string_view>&, std::string_view, std::string_view);
 
 template <class ContainerT>
 void split_by_any_char(ContainerT &parts,
-                       const std::string &line,
-                       const std::string &delims,
+                       std::string_view line,
+                       std::string_view delims,
                        bool keepSplitElements) {
+  using Part = typename ContainerT::value_type;
   size_t last = 0;
   size_t next = 0;
-  while ((next = line.find_first_of(delims, last)) != std::string::npos) {
-    std::string match = line.substr(last, next - last);
+  while ((next = line.find_first_of(delims, last)) != std::string_view::npos) {
+    std::string_view match = line.substr(last, next - last);
     if (!match.empty())
-      parts.push_back(match);
+      parts.push_back(Part(match));
     if (keepSplitElements)
-      parts.push_back(line.substr(next, 1));
+      parts.push_back(Part(line.substr(next, 1)));
     // we search for any character from delims, so we need to
     // skip by a single character.
     last = next + 1;
   }
-  parts.push_back(line.substr(last, next - last));
+  parts.push_back(Part(line.substr(last)));
 }
 
-template void split_by_any_char<std::deque<std::string>>(std::deque<std::string>&, const std::string&, const std::string&, bool);
+template void split_by_any_char<std::deque<std::string>>(std::deque<std::string>&, std::string_view, std::string_view, bool);
+template void split_by_any_char<std::vector<std::string_view>>(std::vector<std::string_view>&, std::string_view, std::string_view, bool);
 
 void debug() {
 #ifdef DEBUG
@@ -1,18 +1,55 @@
 #ifndef __UTILS__H__
 #define __UTILS__H__
 
+// throw_and_debug() also prints what it throws; the message still
+// reaches whoever catches it, so only in debug builds.
+#ifdef DEBUG
 #define UTILS_DEBUG
+#endif
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
-bool isNumber(const std::string &s);
-int getNumber(const std::string &s);
-template <typename T> std::string toString(T n);
+bool isNumber(std::string_view s);
+
+enum class NumberError {
+  OK,
+  INVALID,       // not just an optional sign and digits
+  OUT_OF_RANGE,  // too big for an int, or outside [min, max]
+};
+
+struct ParsedNumber {
+  int value;  // 0 unless ok()
+  NumberError error;
+  bool ok() const { return error == NumberError::OK; }
+};
+
+// all of s has to be a decimal number, like isNumber checks for.
+// doesn't allocate or throw, unlike going through a stream.
+ParsedNumber parseNumber(std::string_view s,
+                         int min = std::numeric_limits<int>::min(),
+                         int max = std::numeric_limits<int>::max());
+// "not a number", "number out of range"
+const char* numberErrorName(NumberError error);
+
+// numbers formatNumber has precomputed: every hack address, constant
+// and register.
+constexpr int HACK_NUMBERS = 1 << 15;
+// big enough for any long long, sign included.
+using NumberBuffer = char[24];
+// decimal text of n, without a stream or an allocation. It's a view
+// into a static table for 0..HACK_NUMBERS-1, else into buf.
+std::string_view formatNumber(long long n, NumberBuffer &buf);
+// writes n's digits right at the end of out.
+void appendNumber(std::string &out, long long n);
+// text followed by n, e.g. withNumber("@", 5) is "@5".
+std::string withNumber(std::string text, long long n);
 
 // filesystem stuff
 
@@ -35,6 +72,13 @@ std::string joinPaths(const std::string &path, const std::string &filename);
 template <class ContainerT>
 void getDirFiles(ContainerT &files, const std::string &dirPath);
 PathType getPathType(const std::string &path);
+// "-" stands for stdin as an input and stdout as an output.
+bool isStdio(const std::string &path);
+
+// progress messages; they go to stderr instead of stdout once
+// the output itself is written to stdout.
+std::ostream& status();
+void statusToStderr();
 
 // string manipulations
 
@@ -44,6 +88,8 @@ void trim(std::string &s);
 std::string ltrim_copy(std::string s);
 std::string rtrim_copy(std::string s);
 std::string trim_copy(std::string s);
+// same as trim, but doesn't copy; returns a narrower view.
+std::string_view trim_view(std::string_view s);
 
 void rstrip(std::string &s, const std::string &chars);
 void lstrip(std::string &s, const std::string &chars);
@@ -51,18 +97,22 @@ void strip(std::string &s, const std::string &chars);
 std::string rstrip_copy(std::string s, const std::string &chars);
 std::string lstrip_copy(std::string s, const std::string &chars);
 std::string strip_copy(std::string s, const std::string &chars);
+// same as the ones above, but return narrower views instead of copies.
+std::string_view rstrip_view(std::string_view s, std::string_view chars);
+std::string_view lstrip_view(std::string_view s, std::string_view chars);
+std::string_view strip_view(std::string_view s, std::string_view chars);
 
-bool startsWith(const std::string &str, const std::string &prefix);
+bool startsWith(std::string_view str, std::string_view prefix);
 
 template <class ContainerT>
 std::string join(const ContainerT &parts, const std::string &delim);
 template <class ContainerT>
-void split(ContainerT &parts, const std::string &line, const std::string &substr);
+void split(ContainerT &parts, std::string_view line, std::string_view substr);
 
 template <class ContainerT>
 void split_by_any_char(ContainerT &parts,
-                       const std::string &line,
-                       const std::string &delims,
+                       std::string_view line,
+                       std::string_view delims,
                        // if to keep the elements we split by in output
                        bool keepSplitElements = false);
 
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <vector>
+
+#include "utils.h"
+#include "watch.h"
+
+// quiet time after the last event, before building.
+constexpr int SETTLE_MS = 15;
+
+Watcher::Watcher(const std::string &path, const std::string &extension)
+  : _path(path), _extension(extension), _fd(-1) {
+  if (getPathType(path) == PathType::DIR_TYPE) {
+    _dir = path;
+  } else {
+    size_t sep = path.rfind(PATHSEP);
+    _dir = sep == std::string::npos ? "." : path.substr(0, sep + 1);
+    _file = getFilename(path);
+  }
+  _fd = inotify_init1(IN_CLOEXEC);
+  if (_fd < 0)
+    throw std::runtime_error("Cannot watch " + path + "\n");
+  // editors often save by writing another file and renaming it over.
+  uint32_t events = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+                    IN_MOVED_TO | IN_MOVED_FROM;
+  if (inotify_add_watch(_fd, _dir.c_str(), events) < 0) {
+    close(_fd);
+    throw std::runtime_error("Cannot watch " + path + "\n");
+  }
+}
+
+Watcher::~Watcher() {
+  close(_fd);
+}
+
+bool Watcher::watched(const std::string &name) const {
+  if (!_file.empty())
+    return name == _file;
+  return getExtension(name) == _extension;
+}
+
+std::vector<std::string> Watcher::wait() {
+  std::vector<std::string> changed;
+  alignas(inotify_event) char buf[4096];
+  int timeout = -1;  // nothing yet, wait as long as it takes
+  for (;;) {
+    pollfd p {_fd, POLLIN, 0};
+    int ready = poll(&p, 1, timeout);
+    if (ready < 0 && errno == EINTR)
+      continue;
+    if (ready < 0)
+      throw std::runtime_error("Cannot watch " + _dir + "\n");
+    if (ready == 0)
+      break;  // settled
+    ssize_t n = read(_fd, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      throw std::runtime_error("Cannot watch " + _dir + "\n");
+    for (char *ptr = buf; ptr < buf + n; ) {
+      const inotify_event *event = reinterpret_cast<const inotify_event*>(ptr);
+      ptr += sizeof(inotify_event) + event->len;
+      if (event->len == 0 || (event->mask & IN_ISDIR))
+        continue;
+      std::string name(event->name);
+      if (watched(name))
+        // named the way the translator names its inputs.
+        changed.push_back(_file.empty() ? joinPaths(_dir, name) : _path);
+    }
+    if (!changed.empty())
+      timeout = SETTLE_MS;
+  }
+  std::sort(changed.begin(), changed.end());
+  changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+  return changed;
+}
@@ -0,0 +1,32 @@
+#ifndef __WATCH__H__
+#define __WATCH__H__
+
+#include <string>
+#include <vector>
+
+// Waits for source files to change, with inotify. path is either a
+// directory, whose files with the given extension are watched, or a
+// single file. Outputs written next to the sources have another
+// extension, so building doesn't wake the watcher up again.
+class Watcher {
+public:
+  Watcher(const std::string &path, const std::string &extension);
+  ~Watcher();
+  Watcher(const Watcher&) = delete;
+  Watcher& operator=(const Watcher&) = delete;
+
+  // blocks until something changed, then returns every file written,
+  // added or removed since, sorted. Editors save in bursts, so it
+  // waits for things to settle first.
+  std::vector<std::string> wait();
+private:
+  bool watched(const std::string &name) const;
+private:
+  std::string _path;
+  std::string _dir;
+  std::string _file;  // only this one in _dir, when watching a file
+  std::string _extension;
+  int _fd;
+};
+
+#endif
@@ -1,157 +1,315 @@
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cstdint>
+#include <exception>
 #include <string>
+#include <string_view>
 #include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 
+#include "generic/output.h"
+#include "generic/parallel.h"
+#include "generic/stats.h"
 #include "generic/utils.h"
 #include "hack/utils.h"
 #include "./builder.h"
+#include "./encoding.h"
 #include "./instruction.h"
 
-HackBuilder::HackBuilder(): Builder() {}
+// HackAssembler
 
-HackBuilder::HackBuilder(const std::string &filename): Builder(filename) {}
+HackAssembler::HackAssembler(): HackBuilder(), _jobs(1), _wordsOnly(false) { }
 
-Instruction* HackBuilder::parseLine(const std::string &line) {
-  std::string instr = trimComment(line);
-  trim(instr);
-
-  if (instr.empty())
-    return nullptr;
-  else if (instr[0] == '@')
-    return new AInstruction(instr);
-  else if (instr[0] == '(')
-    return new Label(instr);
-  else
-    return new CInstruction(instr);
+HackAssembler::HackAssembler(const std::string &filename)
+  : HackBuilder(filename), _jobs(1), _wordsOnly(false) {
+  // nowhere to put it next to stdin.
+  if (!isStdio(filename))
+    _debugFilename = replaceExtension(filename, "asm_debug");
 }
 
-void HackBuilder::visit(HackInstruction *i) { }
-
-// HackSymbolTranslator
+void HackAssembler::setJobs(int jobs) {
+  _jobs = jobs;
+}
 
-HackSymbolTranslator::HackSymbolTranslator()
-  : HackBuilder() {
-  init();
+void HackAssembler::setWordsOnly(bool wordsOnly) {
+  _wordsOnly = wordsOnly;
 }
 
-HackSymbolTranslator::HackSymbolTranslator(const std::string &filename)
-  : HackBuilder(filename) {
-  init();
-  initPredefinedSymbols();
-  _debugFilename = replaceExtension(filename, "asm_debug");
+std::vector<uint16_t> HackAssembler::takeWords() {
+  return std::move(_words);
 }
 
-void HackSymbolTranslator::init() {
-  _firstPass = true;
+void HackAssembler::init() {
   _crtInstructionNo = 0;
-  _crtVariableNo = VARIABLE_START;
+  _symbols = {
+    {"SP", 0},
+    {"LCL", 1},
+    {"ARG", 2},
+    {"THIS", 3},
+    {"THAT", 4},
+    {"SCREEN", 16384},
+    {"KBD", 24576},
+  };
+  // R0 = 0, R1 = 1, ..., R15 = 15
+  for (int i = 0; i < 16; ++i)
+    _symbols[withNumber("R", i)] = i;
+  _unresolvedIds.clear();
+  _unresolved.clear();
+  _fixups.clear();
+  _words.clear();
+  _debugStream.str("");
 }
 
-std::list<std::string>* HackSymbolTranslator::getResult() {
-  HackBuilder::getResult();
-  _firstPass = false;
-  std::list<std::string> *out = HackBuilder::getResult();
+LineBuffer HackAssembler::getResult() {
+  init();
+  LineBuffer out = Builder::getResult();
   writeDebugOutputFile();
   return out;
 }
 
-void HackSymbolTranslator::visit(Label *i) {
-  if (_firstPass) {
-    std::ostringstream oss;
-    oss << _crtInstructionNo;
-    _symbolsTable[i->getName()] = oss.str();
-    writeDebugInstruction(i);
-  } else {
-    // just ignore label from output, we're going to substitute it based
-    // on the table.
+Phase HackAssembler::phase() const {
+  return Phase::ASSEMBLE;
+}
+
+void HackAssembler::processLines(const LineIndex *lines) {
+  if (_jobs > 1 && lines->size() >= PARALLEL_MIN_LINES) {
+    assembleParallel(*lines);
+    return;
   }
+  HackBuilder::processLines(lines);
+  patchFixups();
+  writeText();
 }
 
-void HackSymbolTranslator::visit(CInstruction *i) {
-  if (_firstPass) {
-    writeDebugInstruction(i);
-    incrementInstructionNo();
-  } else
-    output->push_back(i->toString());
+void HackAssembler::visit(Label *i) {
+  Stats::count(Counter::LABELS);
+  // a second definition would change what the code before it
+  // already got.
+  if (!_symbols.emplace(i->getName(), _crtInstructionNo).second)
+    throw std::runtime_error("Symbol defined twice: " + i->toString() + "\n");
+  writeDebugInstruction(i);
 }
 
-void HackSymbolTranslator::visit(AInstruction *i) {
-  if (_firstPass) {
-    writeDebugInstruction(i);
-    incrementInstructionNo();
-  } else {
-    // if it's not a numeric value, then we look it up in the table.
-    // if it's present, we just replace it, otherwise we assume
-    // it's a new variable so we just allocate it a memory location.
-    if (!i->isNumericValue()) {
-      std::string val = i->value();
-      std::string newVal = "";
-      if (_symbolsTable.find(val) != _symbolsTable.end()) {
-        newVal = _symbolsTable[val];
+void HackAssembler::visit(CInstruction *i) {
+  writeDebugInstruction(i);
+  incrementInstructionNo();
+  Stats::count(Counter::INSTRUCTIONS);
+  _words.push_back(static_cast<uint16_t>(i->encode()));
+}
+
+void HackAssembler::visit(AInstruction *i) {
+  writeDebugInstruction(i);
+  incrementInstructionNo();
+  Stats::count(Counter::INSTRUCTIONS);
+  if (i->isNumericValue()) {
+    _words.push_back(static_cast<uint16_t>(i->number()));
+    return;
+  }
+  std::string name = i->value();
+  auto known = _symbols.find(name);
+  if (known != _symbols.end()) {
+    _words.push_back(static_cast<uint16_t>(known->second));
+    return;
+  }
+  auto id = _unresolvedIds.emplace(name, _unresolved.size());
+  if (id.second)
+    _unresolved.push_back(name);
+  _fixups.push_back({_words.size(), id.first->second});
+  _words.push_back(0);
+}
+
+void HackAssembler::patchFixups() {
+  std::vector<int> addresses(_unresolved.size(), -1);
+  int crtVariableNo = VARIABLE_START;
+  for (const Fixup &fixup: _fixups) {
+    int &address = addresses[fixup.symbol];
+    if (address < 0) {
+      auto label = _symbols.find(_unresolved[fixup.symbol]);
+      if (label != _symbols.end()) {
+        address = label->second;
       } else {
-        _symbolsTable[val] = newVal = toString(_crtVariableNo);;
-        incrementVariableNo();
+        // never defined, so it's a variable.
+        address = crtVariableNo;
+        if (++crtVariableNo >= VARIABLE_END)
+          throw std::runtime_error("File uses too many variables, ran out of static memory.\n");
       }
-      i->setValue(newVal);
     }
-
-    output->push_back(i->toString());
+    _words[fixup.line] = static_cast<uint16_t>(address);
   }
 }
 
-void HackSymbolTranslator::initPredefinedSymbols() {
-  _symbolsTable = {
-    {"SP", "0"},
-    {"LCL", "1"},
-    {"ARG", "2"},
-    {"THIS", "3"},
-    {"THAT", "4"},
-    {"SCREEN", "16384"},
-    {"KBD", "24576"},
-  };
-  // R0 = "0", R1 = "1", ..., R15 = "15"
-  for (int i = 0; i < 16; ++i) {
-    std::ostringstream oss;
-    oss << i;
-    std::string num = oss.str();
-    _symbolsTable["R" + num] = num;
-  }
+void HackAssembler::writeText() {
+  if (_wordsOnly)
+    return;
+  char *text = output.appendFixed(_words.size(), HACK_TEXT_WIDTH);
+  for (size_t w = 0; w < _words.size(); ++w)
+    writeHackText(_words[w], text + w * (HACK_TEXT_WIDTH + 1));
 }
 
-void HackSymbolTranslator::writeDebugOutputFile() {
-  std::ofstream out(_debugFilename);
-  out << _debugStream.str();
-  out.flush();
+void HackAssembler::writeDebugOutputFile() {
+  if (_debugFilename.empty())
+    return;
+  OutputSink out(_debugFilename);
+  out.write(_debugStream.str());
+  out.close();
 }
 
-void HackSymbolTranslator::writeDebugInstruction(Instruction *i) {
-  _debugStream << _crtInstructionNo << " " << i->toString() << '\n';
+void HackAssembler::writeDebugInstruction(Instruction *i) {
+  if (!_debugFilename.empty())
+    _debugStream << _crtInstructionNo << " " << i->toString() << '\n';
 }
 
-void HackSymbolTranslator::incrementInstructionNo() {
+void HackAssembler::incrementInstructionNo() {
   if (++_crtInstructionNo > MAX_INT)
     throw std::runtime_error("File has too many lines.\n");
 }
 
-void HackSymbolTranslator::incrementVariableNo() {
-  if (++_crtVariableNo >= VARIABLE_END)
-    throw std::runtime_error("File uses too many variables, ran out of static memory.\n");
-}
+// HackAssembler::Chunk
 
-// HackBinaryTranslator
+// a run of input lines encoded on its own. Labels and symbols are kept
+// relative to the chunk until resolveChunks() knows where it starts.
+struct HackAssembler::Chunk {
+  size_t begin;  // input lines in [begin, end)
+  size_t end;
+  size_t start = 0;  // number of its first instruction
+  std::vector<uint16_t> words;  // a symbol's address is 0 until patched
+  std::vector<std::pair<std::string_view, size_t>> labels;  // name, word
+  // symbols in order of first use, their ids and addresses.
+  std::unordered_map<std::string_view, int> ids;
+  std::vector<std::string_view> symbols;
+  std::vector<int> addresses;
+  std::vector<Fixup> fixups;  // line is in words
+  std::exception_ptr error;   // encoding stops at the first one
 
-HackBinaryTranslator::HackBinaryTranslator(): HackBuilder() { }
+  void add(Label *i) {
+    std::string_view label = i->view();
+    labels.emplace_back(label.substr(1, label.size() - 2), words.size());
+  }
+
+  void add(CInstruction *i) {
+    words.push_back(static_cast<uint16_t>(i->encode()));
+  }
+
+  void add(AInstruction *i) {
+    if (i->isNumericValue()) {
+      words.push_back(static_cast<uint16_t>(i->number()));
+      return;
+    }
+    auto id = ids.emplace(i->view().substr(1), symbols.size());
+    if (id.second)
+      symbols.push_back(id.first->first);
+    fixups.push_back({words.size(), id.first->second});
+    words.push_back(0);
+  }
+};
+
+// The chunks are encoded at once, then resolved in order on this
+// thread, which is where labels get their address and variables theirs
+// in order of first use, and errors are raised in the order a single
+// pass would meet them. Last, each chunk writes its words, or their
+// text, to its own slice of the output, known from where it starts.
+void HackAssembler::assembleParallel(const LineIndex &lines) {
+  size_t nChunks = std::min<size_t>(4 * _jobs, lines.size() / CHUNK_LINES);
+  std::vector<Chunk> chunks(nChunks);
+  for (size_t k = 0; k < nChunks; ++k) {
+    chunks[k].begin = lines.size() * k / nChunks;
+    chunks[k].end = lines.size() * (k + 1) / nChunks;
+  }
+  parallelFor(nChunks, _jobs, [&](int, size_t k) {
+    encodeChunk(lines, chunks[k]);
+  });
+  resolveChunks(chunks);
+
+  // each chunk's words, or text, go right where a single pass puts them.
+  char *text = nullptr;
+  if (_wordsOnly)
+    _words.resize(_crtInstructionNo);
+  else
+    text = output.appendFixed(_crtInstructionNo, HACK_TEXT_WIDTH);
+  std::vector<std::string> debug(nChunks);
+  parallelFor(nChunks, _jobs, [&](int, size_t k) {
+    writeChunk(lines, chunks[k], text, debug[k]);
+  });
+  for (const std::string &text: debug)
+    _debugStream << text;
+}
 
-HackBinaryTranslator::HackBinaryTranslator(const std::string &filename)
-  : HackBuilder(filename) { }
+void HackAssembler::encodeChunk(const LineIndex &lines, Chunk &chunk) {
+  HackInstructions instr;
+  try {
+    for (size_t n = chunk.begin; n < chunk.end; ++n) {
+      parseLine(lines[n], instr);
+      std::visit([&](auto &i) {
+        using T = std::decay_t<decltype(i)>;
+        if constexpr (!std::is_same_v<T, std::monostate>) {
+          if (!i.isValid())
+            invalidLine(lines[n], n + 1);
+          chunk.add(&i);
+        }
+      }, instr);
+    }
+  } catch (...) {
+    chunk.error = std::current_exception();
+  }
+}
 
-void HackBinaryTranslator::visit(Label *i) { }
+void HackAssembler::resolveChunks(std::vector<Chunk> &chunks) {
+  for (Chunk &chunk: chunks) {
+    chunk.start = _crtInstructionNo;
+    for (const auto &label: chunk.labels) {
+      Stats::count(Counter::LABELS);
+      if (!_symbols.emplace(std::string(label.first), chunk.start + label.second).second)
+        throw std::runtime_error("Symbol defined twice: (" + std::string(label.first) + ")\n");
+    }
+    if (_crtInstructionNo + chunk.words.size() > MAX_INT)
+      throw std::runtime_error("File has too many lines.\n");
+    _crtInstructionNo += chunk.words.size();
+    Stats::count(Counter::INSTRUCTIONS, chunk.words.size());
+    if (chunk.error)
+      std::rethrow_exception(chunk.error);
+  }
 
-void HackBinaryTranslator::visit(CInstruction *i) {
-  output->push_back(i->translate());
+  // all labels are known now, so the other symbols are variables.
+  int crtVariableNo = VARIABLE_START;
+  for (Chunk &chunk: chunks) {
+    chunk.addresses.reserve(chunk.symbols.size());
+    for (std::string_view name: chunk.symbols) {
+      auto symbol = _symbols.emplace(std::string(name), crtVariableNo);
+      if (symbol.second && ++crtVariableNo >= VARIABLE_END)
+        throw std::runtime_error("File uses too many variables, ran out of static memory.\n");
+      chunk.addresses.push_back(symbol.first->second);
+    }
+  }
 }
 
-void HackBinaryTranslator::visit(AInstruction *i) {
-  output->push_back(i->translate());
+void HackAssembler::writeChunk(const LineIndex &lines, Chunk &chunk, char *text,
+                               std::string &debug) {
+  for (const Fixup &fixup: chunk.fixups)
+    chunk.words[fixup.line] = static_cast<uint16_t>(chunk.addresses[fixup.symbol]);
+  if (text) {
+    text += chunk.start * (HACK_TEXT_WIDTH + 1);
+    for (size_t w = 0; w < chunk.words.size(); ++w)
+      writeHackText(chunk.words[w], text + w * (HACK_TEXT_WIDTH + 1));
+  } else {
+    std::copy(chunk.words.begin(), chunk.words.end(), _words.begin() + chunk.start);
+  }
+
+  if (_debugFilename.empty())
+    return;
+  // what writeDebugInstruction() writes for these lines.
+  size_t instructionNo = chunk.start;
+  for (size_t n = chunk.begin; n < chunk.end; ++n) {
+    std::string_view code = trim_view(trimComment(lines[n]));
+    if (code.empty())
+      continue;
+    debug += std::to_string(instructionNo);
+    debug += ' ';
+    debug += code;
+    debug += '\n';
+    if (code[0] != '(')
+      ++instructionNo;
+  }
 }
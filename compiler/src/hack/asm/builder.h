@@ -1,54 +1,108 @@
 #ifndef __HACK__BUILDER__H__
 #define __HACK__BUILDER__H__
 
-#include <list>
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "generic/builder.h"
+#include "generic/utils.h"
+#include "hack/utils.h"
 
 #include "./instruction.h"
 
-class HackBuilder: public Builder {
+// Builders over asm code. Derived gets visit(Label*),
+// visit(CInstruction*) and visit(AInstruction*) called for every line.
+template <class Derived>
+class HackBuilder: public InstructionBuilder<Derived, HackInstructions> {
 public:
-  virtual void visit(Label *i) = 0;
-  virtual void visit(CInstruction *i) = 0;
-  virtual void visit(AInstruction *i) = 0;
-  virtual Instruction* parseLine(const std::string &line);
+  void parseLine(std::string_view line, HackInstructions &instr) {
+    std::string_view code = trim_view(trimComment(line));
 
-  virtual void visit(HackInstruction *i);
+    if (code.empty())
+      instr = std::monostate();
+    else if (code[0] == '@')
+      instr.emplace<AInstruction>(code);
+    else if (code[0] == '(')
+      instr.emplace<Label>(code);
+    else
+      instr.emplace<CInstruction>(code);
+  }
 protected:
-  HackBuilder();
-  HackBuilder(const std::string&);  // abstract
+  HackBuilder(): InstructionBuilder<Derived, HackInstructions>() { }
+  HackBuilder(const std::string &filename)  // abstract
+    : InstructionBuilder<Derived, HackInstructions>(filename) { }
 };
 
-class HackSymbolTranslator: public HackBuilder {
+// Assembles in a single pass: every instruction is encoded to a word
+// as soon as it's read. An A-instruction naming a symbol that isn't
+// known yet (a label further down, or a variable) gets a placeholder
+// and a fixup; once the whole program is read the fixups are patched,
+// and the symbols still unknown then become variables, in order of
+// first use. The words are then written out as text, unless they're
+// taken as they are. Besides the output, memory only grows with the
+// words, the labels and those fixups.
+class HackAssembler: public HackBuilder<HackAssembler> {
 public:
-  HackSymbolTranslator();
-  HackSymbolTranslator(const std::string&);
-  virtual void init();
-  virtual std::list<std::string>* getResult() override;
-  virtual void visit(Label *i) override;
-  virtual void visit(CInstruction *i) override;
-  virtual void visit(AInstruction *i) override;
+  HackAssembler();
+  // also writes an .asm_debug file next to filename, unless it's "-".
+  HackAssembler(const std::string&);
+  // large inputs get split into chunks assembled on up to jobs
+  // threads, with the same output as a single one.
+  void setJobs(int jobs);
+  // for output other than text: getResult() then gives no lines, and
+  // the program is taken as words with takeWords() instead.
+  void setWordsOnly(bool wordsOnly);
+  std::vector<uint16_t> takeWords();
+  virtual LineBuffer getResult() override;
+  virtual Phase phase() const override;
+  void visit(Label *i);
+  void visit(CInstruction *i);
+  void visit(AInstruction *i);
+protected:
+  virtual void processLines(const LineIndex *lines) override;
 private:
-  void initPredefinedSymbols();
+  struct Chunk;
+  void init();
+  void patchFixups();
+  void writeText();
+  void assembleParallel(const LineIndex &lines);
+  void encodeChunk(const LineIndex &lines, Chunk &chunk);
+  void resolveChunks(std::vector<Chunk> &chunks);
+  void writeChunk(const LineIndex &lines, Chunk &chunk, char *text,
+                  std::string &debug);
   void writeDebugOutputFile();
   void writeDebugInstruction(Instruction *i);
   void incrementInstructionNo();
-  void incrementVariableNo();
 private:
-  bool _firstPass;
+  struct Fixup {
+    size_t line;  // in _words
+    int symbol;   // in _unresolved
+  };
+  int _jobs;
+  bool _wordsOnly;
+  // the program so far; symbols not known yet are 0 until patched.
+  std::vector<uint16_t> _words;
   int _crtInstructionNo;
-  int _crtVariableNo;
-  std::unordered_map<std::string, std::string> _symbolsTable;
+  // predefined symbols and the labels read so far.
+  std::unordered_map<std::string, int> _symbols;
+  // symbols used while unknown, in order of first use.
+  std::unordered_map<std::string, int> _unresolvedIds;
+  std::vector<std::string> _unresolved;
+  std::vector<Fixup> _fixups;
 
   // filename to output mapping of line numbers to symbols
   std::string _debugFilename;
   std::ostringstream _debugStream;
 
+  // inputs shorter than this aren't worth the threads, and chunks are
+  // at least CHUNK_LINES long.
+  static constexpr size_t PARALLEL_MIN_LINES = 8192;
+  static constexpr size_t CHUNK_LINES = 2048;
   // memory address for variables are in [start,end)
   static constexpr int VARIABLE_START = 16;
   static constexpr int VARIABLE_END = 256;
@@ -58,13 +112,4 @@ private:
   static constexpr int MAX_INT = (1 << 15) - 1;
 };
 
-class HackBinaryTranslator: public HackBuilder {
-public:
-  HackBinaryTranslator();
-  HackBinaryTranslator(const std::string&);
-  virtual void visit(Label *i) override;
-  virtual void visit(CInstruction *i) override;
-  virtual void visit(AInstruction *i) override;
-};
-
 #endif
@@ -0,0 +1,220 @@
+#ifndef __HACK__ENCODING__H__
+#define __HACK__ENCODING__H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// C-instruction fields as bits of the 16-bit word:
+//   111a cccc ccdd djjj
+// the tables below are built at compile time and shared by the
+// assembler (mnemonic -> bits) and any decoder (bits -> mnemonic).
+
+constexpr uint16_t C_PREFIX = 0xE000;
+constexpr int COMP_SHIFT = 6;
+constexpr int DEST_SHIFT = 3;
+constexpr uint16_t COMP_MASK = 0x7F << COMP_SHIFT;
+constexpr uint16_t DEST_MASK = 0x7 << DEST_SHIFT;
+constexpr uint16_t JUMP_MASK = 0x7;
+
+struct Mnemonic {
+  std::string_view name;
+  uint16_t bits;
+};
+
+// canonical spellings, the ones a decoder prints.
+constexpr Mnemonic COMP_MNEMONICS[] = {
+  //                acccccc
+  {"0",   0b0101010 << COMP_SHIFT},
+  {"1",   0b0111111 << COMP_SHIFT},
+  {"-1",  0b0111010 << COMP_SHIFT},
+  {"D",   0b0001100 << COMP_SHIFT},
+  {"A",   0b0110000 << COMP_SHIFT}, {"M",   0b1110000 << COMP_SHIFT},
+  {"!D",  0b0001101 << COMP_SHIFT},
+  {"!A",  0b0110001 << COMP_SHIFT}, {"!M",  0b1110001 << COMP_SHIFT},
+  {"-D",  0b0001111 << COMP_SHIFT},
+  {"-A",  0b0110011 << COMP_SHIFT}, {"-M",  0b1110011 << COMP_SHIFT},
+  {"D+1", 0b0011111 << COMP_SHIFT},
+  {"A+1", 0b0110111 << COMP_SHIFT}, {"M+1", 0b1110111 << COMP_SHIFT},
+  {"D-1", 0b0001110 << COMP_SHIFT},
+  {"A-1", 0b0110010 << COMP_SHIFT}, {"M-1", 0b1110010 << COMP_SHIFT},
+  {"D+A", 0b0000010 << COMP_SHIFT}, {"D+M", 0b1000010 << COMP_SHIFT},
+  {"D-A", 0b0010011 << COMP_SHIFT}, {"D-M", 0b1010011 << COMP_SHIFT},
+  {"A-D", 0b0000111 << COMP_SHIFT}, {"M-D", 0b1000111 << COMP_SHIFT},
+  {"D&A", 0b0000000 << COMP_SHIFT}, {"D&M", 0b1000000 << COMP_SHIFT},
+  {"D|A", 0b0010101 << COMP_SHIFT}, {"D|M", 0b1010101 << COMP_SHIFT},
+};
+
+constexpr Mnemonic DEST_MNEMONICS[] = {
+  {"",    0b000 << DEST_SHIFT},
+  {"M",   0b001 << DEST_SHIFT},
+  {"D",   0b010 << DEST_SHIFT},
+  {"MD",  0b011 << DEST_SHIFT},
+  {"A",   0b100 << DEST_SHIFT},
+  {"AM",  0b101 << DEST_SHIFT},
+  {"AD",  0b110 << DEST_SHIFT},
+  {"AMD", 0b111 << DEST_SHIFT},
+};
+
+constexpr Mnemonic JUMP_MNEMONICS[] = {
+  {"",    0b000},
+  {"JGT", 0b001},
+  {"JEQ", 0b010},
+  {"JGE", 0b011},
+  {"JLT", 0b100},
+  {"JNE", 0b101},
+  {"JLE", 0b110},
+  {"JMP", 0b111},
+};
+
+// every mnemonic is at most 3 chars, so it packs into an integer key
+// with its length on top, and "" is a valid key.
+constexpr int MAX_MNEMONIC = 3;
+constexpr uint32_t NO_KEY = ~uint32_t(0);
+
+constexpr uint32_t mnemonicKey(std::string_view name) {
+  if (name.size() > MAX_MNEMONIC)
+    return NO_KEY;
+  uint32_t key = static_cast<uint32_t>(name.size()) << 24;
+  for (size_t i = 0; i < name.size(); ++i)
+    key |= static_cast<uint32_t>(static_cast<unsigned char>(name[i])) << (8 * i);
+  return key;
+}
+
+// open addressing table over mnemonicKey, filled at compile time.
+template <int BITS>
+class MnemonicTable {
+public:
+  static constexpr int SIZE = 1 << BITS;
+
+  constexpr void insert(std::string_view name, uint16_t bits) {
+    uint32_t key = mnemonicKey(name);
+    int slot = hash(key);
+    while (_used[slot] && _keys[slot] != key)
+      slot = (slot + 1) & (SIZE - 1);
+    _used[slot] = true;
+    _keys[slot] = key;
+    _bits[slot] = bits;
+  }
+
+  // the field bits of name, or -1 when it isn't a mnemonic.
+  constexpr int find(std::string_view name) const {
+    uint32_t key = mnemonicKey(name);
+    if (key == NO_KEY)
+      return -1;
+    for (int slot = hash(key); _used[slot]; slot = (slot + 1) & (SIZE - 1))
+      if (_keys[slot] == key)
+        return _bits[slot];
+    return -1;
+  }
+
+private:
+  static constexpr int hash(uint32_t key) {
+    return static_cast<int>((key * 2654435761u) >> (32 - BITS));
+  }
+
+  bool _used[SIZE] = {};
+  uint32_t _keys[SIZE] = {};
+  uint16_t _bits[SIZE] = {};
+};
+
+template <int BITS, size_t N>
+constexpr MnemonicTable<BITS> makeMnemonicTable(const Mnemonic (&mnemonics)[N]) {
+  MnemonicTable<BITS> table {};
+  for (const Mnemonic &m: mnemonics)
+    table.insert(m.name, m.bits);
+  return table;
+}
+
+// comp also accepts YopX for the commutative XopY, op being + | or &.
+template <int BITS, size_t N>
+constexpr MnemonicTable<BITS> makeCompTable(const Mnemonic (&mnemonics)[N]) {
+  MnemonicTable<BITS> table = makeMnemonicTable<BITS>(mnemonics);
+  for (const Mnemonic &m: mnemonics) {
+    std::string_view name = m.name;
+    if (name.size() != 3 || (name[1] != '+' && name[1] != '|' && name[1] != '&'))
+      continue;
+    const char swapped[] = {name[2], name[1], name[0]};
+    table.insert(std::string_view(swapped, 3), m.bits);
+  }
+  return table;
+}
+
+constexpr MnemonicTable<7> COMP_TABLE = makeCompTable<7>(COMP_MNEMONICS);
+constexpr MnemonicTable<4> DEST_TABLE = makeMnemonicTable<4>(DEST_MNEMONICS);
+constexpr MnemonicTable<4> JUMP_TABLE = makeMnemonicTable<4>(JUMP_MNEMONICS);
+
+// the C-instruction word for the parts, or -1 if any isn't a mnemonic.
+constexpr int encodeCInstruction(std::string_view dest, std::string_view comp,
+                                 std::string_view jump) {
+  int c = COMP_TABLE.find(comp);
+  int d = DEST_TABLE.find(dest);
+  int j = JUMP_TABLE.find(jump);
+  if (c < 0 || d < 0 || j < 0)
+    return -1;
+  return C_PREFIX | c | d | j;
+}
+
+template <size_t N>
+constexpr bool decodeField(const Mnemonic (&mnemonics)[N], uint16_t bits,
+                           std::string_view &name) {
+  for (const Mnemonic &m: mnemonics) {
+    if (m.bits == bits) {
+      name = m.name;
+      return true;
+    }
+  }
+  return false;
+}
+
+// the canonical mnemonics of a C-instruction word, false if it has none.
+constexpr bool decodeCInstruction(uint16_t word, std::string_view &dest,
+                                  std::string_view &comp, std::string_view &jump) {
+  return (
+    (word & C_PREFIX) == C_PREFIX &&
+    decodeField(COMP_MNEMONICS, word & COMP_MASK, comp) &&
+    decodeField(DEST_MNEMONICS, word & DEST_MASK, dest) &&
+    decodeField(JUMP_MNEMONICS, word & JUMP_MASK, jump)
+  );
+}
+
+static_assert(encodeCInstruction("", "0", "JMP") == 0b1110101010000111);
+static_assert(encodeCInstruction("AM", "M+1", "") == 0b1111110111101000);
+static_assert(encodeCInstruction("D", "A+D", "") == encodeCInstruction("D", "D+A", ""));
+static_assert(encodeCInstruction("DM", "D", "") == -1);
+static_assert(encodeCInstruction("", "D+D", "") == -1);
+
+// decoding gives back the canonical spelling of what got encoded.
+constexpr bool decodesTo(std::string_view dest, std::string_view comp, std::string_view jump,
+                         std::string_view canonicalComp) {
+  int word = encodeCInstruction(dest, comp, jump);
+  std::string_view d, c, j;
+  return (
+    word >= 0 &&
+    decodeCInstruction(static_cast<uint16_t>(word), d, c, j) &&
+    d == dest && c == canonicalComp && j == jump
+  );
+}
+
+static_assert(decodesTo("", "0", "JMP", "0"));
+static_assert(decodesTo("AMD", "M-1", "", "M-1"));
+static_assert(decodesTo("D", "1+D", "JNE", "D+1"));
+static_assert(decodesTo("M", "M&D", "", "D&M"));
+static_assert(decodesTo("MD", "A|D", "JLE", "D|A"));
+
+// the text form of a word, as written to .hack files: one char a bit.
+constexpr int HACK_TEXT_WIDTH = 16;
+
+inline void writeHackText(uint16_t word, char *out) {
+  for (int i = HACK_TEXT_WIDTH - 1; i >= 0; --i, word >>= 1)
+    out[i] = static_cast<char>('0' + (word & 1));
+}
+
+inline std::string hackText(uint16_t word) {
+  std::string text(HACK_TEXT_WIDTH, '0');
+  writeHackText(word, &text[0]);
+  return text;
+}
+
+#endif
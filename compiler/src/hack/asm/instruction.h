@@ -2,63 +2,67 @@
 #define __HACK__INSTRUCTION__H__
 
 #include <string>
+#include <string_view>
+#include <variant>
 
 #include "generic/instruction.h"
 
-class HackBuilder;
-
 class HackInstruction: public Instruction {
 protected:
-  HackInstruction(std::string);  // abstract
-  virtual void accept(Builder*) override;
+  HackInstruction(std::string_view);  // abstract
 };
 
-class AInstruction: public HackInstruction {
+class AInstruction final: public HackInstruction {
 public:
-  AInstruction(std::string);
+  AInstruction(std::string_view);
   std::string value();
   void setValue(std::string);
   bool isValid() override;
   bool isNumericValue();
+  // the address a numeric A-instruction loads.
+  int number();
   std::string translate() override;
-
-  virtual void accept(Builder*) override;
+  // the binary of an A-instruction loading value.
+  static std::string encode(int value);
 private:
   // A-instruction's value can hold at most a 15-bit integer.
   static constexpr int BITS_VALUE = 15;
   static constexpr int MAX_VALUE = 1 << BITS_VALUE;
 };
 
-class CInstruction: public HackInstruction {
+class CInstruction final: public HackInstruction {
 public:
-  CInstruction(std::string);
+  // parses the line once, the rest only reads what it found.
+  CInstruction(std::string_view);
   bool isValid() override;
   std::string translate() override;
-
-  virtual void accept(Builder*) override;
+  // the instruction word, or -1 if a part isn't a mnemonic.
+  int encode() const;
+  // the parts are views into the line, so they live as long as it does.
+  std::string_view dest() const;
+  std::string_view comp() const;
+  std::string_view jmp() const;
 private:
-  std::string dest();
-  std::string comp();
-  std::string jmp();
-
-  static std::unordered_map<std::string, std::string> createComputationTable();
-
+  void parse();
 private:
-  static std::unordered_map<std::string, std::string> _compToBinary;
-  static std::unordered_map<std::string, std::string> _destToBinary;
-  static std::unordered_map<std::string, std::string> _jumpToBinary;
+  std::string_view _dest;
+  std::string_view _comp;
+  std::string_view _jmp;
+  int _word;
 };
 
-class Label: public HackInstruction {
+class Label final: public HackInstruction {
 public:
-  Label(std::string);
+  Label(std::string_view);
   bool isValid() override;
   std::string translate() override;
 
-  virtual void accept(Builder*) override;
-
   std::string getName();
 private:
 };
 
+// every kind of line in an asm file, see InstructionBuilder.
+using HackInstructions = std::variant<std::monostate,
+                                      AInstruction, CInstruction, Label>;
+
 #endif
@@ -1,6 +1,15 @@
+#include <list>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "generic/line_buffer.h"
+#include "generic/source.h"
+#include "generic/stats.h"
+#include "generic/trace.h"
 #include "generic/utils.h"
+#include "hack/format.h"
+#include "hack/library.h"
 
 #include "./builder.h"
 #include "./translator.h"
@@ -10,14 +19,63 @@ Translator* getTranslatorFromPath(const std::string &path) {
 }
 
 AsmHackTranslator::AsmHackTranslator(const std::string &path)
-  : HackTranslator(path) {
-  _builders.push_back(new HackSymbolTranslator(path));
-  _builders.push_back(new HackBinaryTranslator(path));
+  : HackTranslator(path) { }
+
+std::list<Builder*> AsmHackTranslator::createBuilders() {
+  // the whole program is a single input, so it's the assembler that
+  // gets the threads; its .asm_debug goes next to the output.
+  HackAssembler *assembler = new HackAssembler(programFile("asm"));
+  assembler->setJobs(_jobs);
+  assembler->setWordsOnly(_format != HackFormat::TEXT);
+  return { assembler };
+}
+
+void AsmHackTranslator::translate() {
+  std::list<std::string> inputList = getInputFiles();
+  std::vector<std::string> inputFiles(inputList.begin(), inputList.end());
+  if (!_makeLibrary.empty()) {
+    makeLibrary(inputFiles);
+    return;
+  }
+  // labels and variables are shared by all the files, so they're
+  // assembled as one program, in order.
+  createWorkers(1);
+  std::vector<std::unique_ptr<SourceBuffer>> sources;
+  for (const std::string &inputFile: inputFiles) {
+    status() << "Reading single file " + inputFile + "\n";
+    TraceSpan fileSpan("file", inputFile);
+    sources.emplace_back(new SourceBuffer(inputFile));
+    Stats::count(Counter::FILES);
+    Stats::addWork(Phase::READ, sources.back()->contents().size());
+  }
+  LineBuffer program;
+  LineIndex programLines;
+  const LineIndex *lines = &programLines;
+  // a single file is assembled straight from its buffer.
+  if (sources.size() == 1 && _libraries.empty()) {
+    lines = &sources.front()->lines();
+  } else {
+    for (const std::unique_ptr<SourceBuffer> &source: sources)
+      program.appendText(source->contents());
+    if (!_libraries.empty()) {
+      Linker linker = createLinker();
+      linker.scan(program);
+      program.append(linkLibraries(linker));
+    }
+    programLines = program.index();
+  }
+  Stats::count(Counter::LINES_IN, lines->size());
+  LineBuffer binary = runBuilders(getBuilders(0), *lines, programFile("asm"));
+  if (_format != HackFormat::TEXT)
+    writeWords(static_cast<HackAssembler*>(getBuilders(0).front())->takeWords());
+  else
+    writeToFile(binary);
 }
 
 std::string AsmHackTranslator::getOutputFile() {
-  return replaceExtension(_path, "hack");
+  return programFile(hackExtension(_format));
 }
 
 std::string AsmHackTranslator::extension() { return "asm"; }
 
+bool AsmHackTranslator::outputsHack() { return true; }
@@ -1,14 +1,23 @@
 #ifndef __HACK__ASM__TRANSLATOR__H__
 #define __HACK__ASM__TRANSLATOR__H__
 
+#include <list>
+#include <string>
+
 #include "hack/translator.h"
 
 class AsmHackTranslator : public HackTranslator {
 public:
   AsmHackTranslator(const std::string &path);
+  // all the input files make up a single program, read in order, so
+  // their labels and variables are shared. Formats other than text get
+  // written straight from the words the assembler makes.
+  virtual void translate() override;
 protected:
+  virtual std::list<Builder*> createBuilders() override;
   virtual std::string getOutputFile() override;
   virtual std::string extension() override;
+  virtual bool outputsHack() override;
 };
 
 #endif
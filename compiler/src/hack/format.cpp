@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "generic/output.h"
+#include "generic/stats.h"
+#include "generic/trace.h"
+
+#include "./format.h"
+
+// words per Intel HEX data record
+static constexpr size_t HEX_RECORD_WORDS = 8;
+static constexpr uint16_t ROM_VERSION = 1;
+
+HackFormat parseHackFormat(const std::string &name) {
+  if (name == "text")
+    return HackFormat::TEXT;
+  if (name == "bin")
+    return HackFormat::BIN;
+  if (name == "hex")
+    return HackFormat::HEX;
+  if (name == "rom")
+    return HackFormat::ROM;
+  throw std::runtime_error("Unknown format " + name + ", expected text, bin, hex or rom\n");
+}
+
+std::string hackExtension(HackFormat format) {
+  switch (format) {
+    case HackFormat::BIN: return "bin";
+    case HackFormat::HEX: return "hex";
+    case HackFormat::ROM: return "rom";
+    default: return "hack";
+  }
+}
+
+static void putWord(std::string &out, uint16_t word) {
+  out.push_back(static_cast<char>(word >> 8));
+  out.push_back(static_cast<char>(word & 0xff));
+}
+
+static void putHexByte(std::string &out, uint8_t byte, uint8_t &checksum) {
+  static const char digits[] = "0123456789ABCDEF";
+  out.push_back(digits[byte >> 4]);
+  out.push_back(digits[byte & 0xf]);
+  checksum += byte;
+}
+
+// :LLAAAATT<data>CC, the checksum making all the bytes add up to 0.
+static void putHexRecord(std::string &out, uint16_t address, uint8_t type,
+                         const uint16_t *words, size_t count) {
+  uint8_t checksum = 0;
+  out.push_back(':');
+  putHexByte(out, static_cast<uint8_t>(count * 2), checksum);
+  putHexByte(out, static_cast<uint8_t>(address >> 8), checksum);
+  putHexByte(out, static_cast<uint8_t>(address & 0xff), checksum);
+  putHexByte(out, type, checksum);
+  for (size_t i = 0; i < count; ++i) {
+    putHexByte(out, static_cast<uint8_t>(words[i] >> 8), checksum);
+    putHexByte(out, static_cast<uint8_t>(words[i] & 0xff), checksum);
+  }
+  uint8_t unused = 0;
+  putHexByte(out, static_cast<uint8_t>(-checksum), unused);
+  out.push_back('\n');
+}
+
+std::string encodeHack(const std::vector<uint16_t> &words, HackFormat format) {
+  // several files assembled together can go past it, and then the
+  // count and the addresses below would wrap.
+  if (words.size() > HACK_ROM_WORDS && format != HackFormat::TEXT)
+    throw std::runtime_error("Program has " + std::to_string(words.size()) +
+                             " instructions, more than the " +
+                             std::to_string(HACK_ROM_WORDS) + " the ROM holds.\n");
+  std::string out;
+  switch (format) {
+    case HackFormat::ROM:
+      out = "HROM";
+      putWord(out, ROM_VERSION);
+      // at most HACK_ROM_WORDS, so the count fits
+      putWord(out, static_cast<uint16_t>(words.size()));
+      // fall through
+    case HackFormat::BIN:
+      out.reserve(out.size() + words.size() * 2);
+      for (uint16_t word: words)
+        putWord(out, word);
+      break;
+    case HackFormat::HEX:
+      // 32K words are 64K bytes, so 16-bit addresses are enough.
+      for (size_t i = 0; i < words.size(); i += HEX_RECORD_WORDS) {
+        size_t count = std::min(HEX_RECORD_WORDS, words.size() - i);
+        putHexRecord(out, static_cast<uint16_t>(i * 2), 0, &words[i], count);
+      }
+      putHexRecord(out, 0, 1, nullptr, 0);  // end of file
+      break;
+    default:
+      throw std::logic_error("encodeHack() is for formats other than text");
+  }
+  return out;
+}
+
+void writeHack(const std::vector<uint16_t> &words, HackFormat format,
+               const std::string &path) {
+  TraceSpan span("pass", phaseName(Phase::WRITE) + (" " + path));
+  PhaseTimer timer(Phase::WRITE);
+  std::string out = encodeHack(words, format);
+  Stats::count(Counter::LINES_OUT, words.size());
+  Stats::addWork(Phase::WRITE, out.size());
+  OutputSink sink(path);
+  sink.writeNoCopy(out);
+  sink.close();
+}
@@ -0,0 +1,33 @@
+#ifndef __HACK__FORMAT__H__
+#define __HACK__FORMAT__H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// How hack code gets written. TEXT is the lines the assembler makes,
+// the others are made from the words it hands over instead. Words are
+// big-endian everywhere, the same order as the bits in the text.
+enum class HackFormat {
+  TEXT,  // a line of 16 '0'/'1' chars per instruction, the usual .hack
+  BIN,   // packed 16-bit words, nothing else
+  HEX,   // Intel HEX, byte addresses from 0, 8 words per record
+  ROM,   // "HROM", a 16-bit version (1) and word count, then the words
+};
+
+// what the hack ROM holds; encodeHack() throws for longer programs.
+constexpr size_t HACK_ROM_WORDS = 1 << 15;
+
+// "text", "bin", "hex" or "rom"; throws for anything else.
+HackFormat parseHackFormat(const std::string &name);
+// file extension for output in format, "hack" for TEXT.
+std::string hackExtension(HackFormat format);
+
+// the whole output, in a format other than TEXT.
+std::string encodeHack(const std::vector<uint16_t> &words, HackFormat format);
+// words of a whole program, written to path in a format other than TEXT.
+void writeHack(const std::vector<uint16_t> &words, HackFormat format,
+               const std::string &path);
+
+#endif
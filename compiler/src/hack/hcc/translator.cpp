@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "generic/line_buffer.h"
+#include "generic/output.h"
+#include "generic/parallel.h"
+#include "generic/source.h"
+#include "generic/trace.h"
+#include "generic/utils.h"
+#include "hack/asm/builder.h"
+#include "hack/library.h"
+#include "hack/jack/builder.h"
+#include "hack/vm/builder.h"
+
+#include "./translator.h"
+
+Translator* getTranslatorFromPath(const std::string &path) {
+  return new HccTranslator(path);
+}
+
+HccTranslator::HccTranslator(const std::string &path): HackTranslator(path) { }
+
+HccTranslator::~HccTranslator() {
+  for (JackCompilationEngineBuilder *builder: _jackBuilders)
+    delete builder;
+  for (Builder *builder: _asmBuilders)
+    delete builder;
+}
+
+std::list<Builder*> HccTranslator::createBuilders() {
+  return { new HackBuilderVMTranslator() };
+}
+
+void HccTranslator::translate() {
+  status() << "Compiling " << _path << '\n';
+  std::list<std::string> inputList = getInputFiles();
+  std::vector<std::string> inputFiles(inputList.begin(), inputList.end());
+  if (!_makeLibrary.empty()) {
+    makeLibrary(inputFiles);
+    return;
+  }
+  std::vector<LineBuffer> asmCode(inputFiles.size());
+
+  int workers = std::max(1, std::min<int>(_jobs, inputFiles.size()));
+  createWorkers(workers);
+  while (static_cast<int>(_jackBuilders.size()) < workers)
+    _jackBuilders.push_back(new JackCompilationEngineBuilder());
+  parallelFor(inputFiles.size(), _jobs, [&](int worker, size_t i) {
+    asmCode[i] = compileClass(inputFiles[i], worker);
+  });
+
+  // same program VMTranslator makes out of the .vm files.
+  LineBuffer program;
+  for (LineBuffer &lines: asmCode) {
+    program.append(lines);
+    program.push_back("");
+  }
+  if (!isStdio(_path) && getPathType(_path) == PathType::DIR_TYPE)
+    program.prepend(HackBuilderVMTranslator::getBootstrapCode());
+  if (!_libraries.empty()) {
+    Linker linker = createLinker();
+    linker.scan(program);
+    program.append(linkLibraries(linker));
+  }
+
+  std::string asmFile = programFile("asm");
+  if (_saveTemps && !isStdio(asmFile))
+    writeLines(program, asmFile);
+
+  // labels are global, so assembling waits for the whole program.
+  if (_asmBuilders.empty()) {
+    // it writes the .asm_debug file next to the .asm one, if any.
+    HackAssembler *assembler = new HackAssembler(_saveTemps ? asmFile : "-");
+    // nothing else runs by now, so it gets all the threads.
+    assembler->setJobs(_jobs);
+    _asmBuilders = { assembler };
+  }
+  HackAssembler *assembler = static_cast<HackAssembler*>(_asmBuilders.front());
+  assembler->setWordsOnly(_format != HackFormat::TEXT);
+  LineIndex asmLines = program.index();
+  LineBuffer binary = runBuilders(_asmBuilders, asmLines, asmFile);
+  if (_format != HackFormat::TEXT) {
+    writeWords(assembler->takeWords());
+    return;
+  }
+  // no empty line at the end, hack text is only words.
+  writeToFile(binary);
+}
+
+LineBuffer HccTranslator::compileClass(const std::string &jackFile,
+                                       int worker) {
+  status() << "Compiling single file " + jackFile + "\n";
+  TraceSpan fileSpan("file", jackFile);
+  // read once, for both the cache key and the tokenizer.
+  SourceBuffer source(jackFile);
+  auto compile = [&] {
+    LineBuffer vmCode = _jackBuilders.at(worker)->compileSource(source);
+
+    std::string vmFile = isStdio(jackFile) ? jackFile : replaceExtension(jackFile, "vm");
+    if (_saveTemps && !isStdio(vmFile))
+      writeLines(vmCode, vmFile);
+
+    LineIndex vmLines = vmCode.index();
+    return runBuilders(getBuilders(worker), vmLines, vmFile);
+  };
+  // a cache hit wouldn't make the .vm file.
+  if (_saveTemps || isStdio(jackFile))
+    return compile();
+  return cached(jackFile, source.contents(), compile);
+}
+
+std::string HccTranslator::getOutputFile() {
+  return programFile(hackExtension(_format));
+}
+
+std::string HccTranslator::extension() { return "jack"; }
+
+// classes are cached up to asm, assembling needs the whole program.
+std::string HccTranslator::cacheStage() { return "jack-asm"; }
+
+bool HccTranslator::linksVM() { return true; }
+
+bool HccTranslator::outputsHack() { return true; }
@@ -0,0 +1,39 @@
+#ifndef __HACK__HCC__TRANSLATOR__H__
+#define __HACK__HCC__TRANSLATOR__H__
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "generic/line_buffer.h"
+#include "hack/translator.h"
+
+class JackCompilationEngineBuilder;
+
+// Compiles jack straight to hack: every class goes through the jack
+// compiler and the vm translator in memory, then the whole program
+// goes through the single-pass assembler. The .vm and .asm files in
+// between are only written with setSaveTemps().
+class HccTranslator: public HackTranslator {
+public:
+  HccTranslator(const std::string &path);
+  ~HccTranslator();
+  virtual void translate() override;
+protected:
+  // the vm translator, one per worker; classes are independent
+  // until they are assembled.
+  virtual std::list<Builder*> createBuilders() override;
+  virtual std::string getOutputFile() override;
+  virtual std::string extension() override;
+  virtual std::string cacheStage() override;
+  virtual bool linksVM() override;
+  virtual bool outputsHack() override;
+private:
+  // jack -> vm -> asm for one class.
+  LineBuffer compileClass(const std::string &jackFile, int worker);
+private:
+  std::vector<JackCompilationEngineBuilder*> _jackBuilders;  // per worker
+  std::list<Builder*> _asmBuilders;
+};
+
+#endif
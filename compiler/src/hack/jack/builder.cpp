@@ -1,9 +1,14 @@
-#include <fstream>
 #include <functional>
 #include <iostream>
 #include <string>
 #include <utility>
 
+#include "generic/cache.h"
+#include "generic/line_buffer.h"
+#include "generic/output.h"
+#include "generic/source.h"
+#include "generic/stats.h"
+#include "generic/trace.h"
 #include "generic/utils.h"
 
 #include "./builder.h"
@@ -13,29 +18,63 @@
 
 // JackBuilder
 
-JackBuilder::JackBuilder() { }
+JackBuilder::JackBuilder(): _cache(nullptr) { }
 
 JackBuilder::~JackBuilder() { }
 
+LineBuffer JackBuilder::getCachedResult(const std::string &inputFile) {
+  if (!_cache || isStdio(inputFile))
+    return getResult(inputFile);
+  SourceBuffer source(inputFile);
+  return _cache->get(source.contents(),
+                     BuildCache::salt(cacheStage(), inputFile, _cacheOptions),
+                     [&] { return getResult(inputFile); });
+}
+
+void JackBuilder::setCache(BuildCache *cache, const std::string &options) {
+  _cache = cache;
+  _cacheOptions = options;
+}
+
+const LineIndex& JackBuilder::readSource(SourceBuffer &source) {
+  TraceSpan span("pass", phaseName(Phase::READ));
+  PhaseTimer timer(Phase::READ);
+  const LineIndex &lines = source.lines();
+  Stats::count(Counter::FILES);
+  Stats::count(Counter::LINES_IN, lines.size());
+  Stats::addWork(Phase::READ, source.contents().size());
+  return lines;
+}
+
+void JackBuilder::write(const LineBuffer &lines, const std::string &outputFile) {
+  writeLines(lines, outputFile);
+}
+
 // JackTokenizerBuilder
 
 JackTokenizerBuilder::JackTokenizerBuilder() : JackBuilder() { }
 
 void JackTokenizerBuilder::build(const std::string &inputFile) {
   std::string outputFile = replaceExtension(inputFile, "T.xml");
-  std::cout << "Extracting tokens from " << inputFile << " into " << outputFile << '\n';
+  status() << "Extracting tokens from " << inputFile << " into " << outputFile << '\n';
+  write(getCachedResult(inputFile), outputFile);
+}
 
-  std::ifstream in(inputFile);
-  JackTokenizer tokenizer(in);
+std::string JackTokenizerBuilder::cacheStage() { return "jack-xml"; }
 
-  std::ofstream out(outputFile);
-  out << "<tokens>\n";
+LineBuffer JackTokenizerBuilder::getResult(const std::string &inputFile) {
+  SourceBuffer source(inputFile);
+  JackTokenizer tokenizer(readSource(source));
+
+  LineBuffer out;
+  out.push_back("<tokens>");
   while (tokenizer.hasMore()) {
     const Token token = tokenizer.getCurrentToken();
-    out << token.toXML() << "\n";
+    out.push_back(token.toXML());
     tokenizer.advance();
   }
-  out << "</tokens>\n";
+  out.push_back("</tokens>");
+  return out;
 }
 
 // JackCompilationEngineBuilder
@@ -43,9 +82,32 @@ void JackTokenizerBuilder::build(const std::string &inputFile) {
 JackCompilationEngineBuilder::JackCompilationEngineBuilder(): JackBuilder() { }
 
 void JackCompilationEngineBuilder::build(const std::string &inputFile) {
-  std::ifstream in(inputFile);
-  JackTokenizer tokenizer(in);
-  ClassElement classElement = buildClass(tokenizer);
+  // output vm code
+  std::string outputFile = replaceExtension(inputFile, "vm");
+  status() << "Extracting parsed grammar from " << inputFile << " into " << outputFile << '\n';
+  write(getCachedResult(inputFile), outputFile);
+}
+
+std::string JackCompilationEngineBuilder::cacheStage() { return "jack-vm"; }
+
+LineBuffer JackCompilationEngineBuilder::getResult(const std::string &inputFile) {
+  TraceSpan fileSpan("file", inputFile);
+  SourceBuffer source(inputFile);
+  return compileSource(source);
+}
+
+LineBuffer JackCompilationEngineBuilder::compileSource(SourceBuffer &source) {
+  return compile(readSource(source));
+}
+
+LineBuffer JackCompilationEngineBuilder::compile(const LineIndex &lines) {
+  JackTokenizer tokenizer(lines);
+  TraceSpan classSpan("class");
+  ClassElement classElement = [&] {
+    PhaseTimer timer(Phase::PARSE);
+    return buildClass(tokenizer);
+  }();
+  classSpan.setName(classElement.getName());
 
   // output parsed tree to xml format.
   //std::string xmlOutputFile = replaceExtension(inputFile, "xml");
@@ -53,12 +115,17 @@ void JackCompilationEngineBuilder::build(const std::string &inputFile) {
   //std::ofstream xmlOut(xmlOutputFile);
   //xmlOut << classElement.toXML();
 
-  // output vm code
-  std::string outputFile = replaceExtension(inputFile, "vm");
-  std::cout << "Extracting parsed grammar from " << inputFile << " into " << outputFile << '\n';
-  std::ofstream out(outputFile);
+  PhaseTimer timer(Phase::CODEGEN);
   SymbolTable symbolTable;
-  out << join(classElement.toVMCode(symbolTable), "\n");
+  LineBuffer out;
+  for (const std::string &line : classElement.toVMCode(symbolTable)) {
+    if (Stats::enabled() && startsWith(line, "label "))
+      Stats::count(Counter::LABELS);
+    out.push_back(line);
+  }
+  Stats::count(Counter::INSTRUCTIONS, out.size());
+  Stats::addWork(Phase::CODEGEN, out.size());
+  return out;
 }
 
 /* class <className> { <classVarDec*> <subroutineDec*> } */
@@ -109,6 +176,7 @@ std::vector<SubroutineDec> JackCompilationEngineBuilder::buildSubroutineDecs(Jac
 
   while (t.hasMore() &&
          in_array(t.getCurrentToken().value(), {"constructor", "function", "method"})) {
+    TraceSpan span("parse");
     // constructor|function|method
     Token kind = eat(t, [](Token tok) {
       return in_array(tok.value(), {"constructor", "function", "method"});
@@ -120,6 +188,7 @@ std::vector<SubroutineDec> JackCompilationEngineBuilder::buildSubroutineDecs(Jac
 
     // <subroutineName>
     Token name = eat(t, [](Token tok) { return tok.isIdentifier(); });
+    span.setName(className + "." + name.value());
     eat(t, "(");
     ParameterList parameters = buildParameterList(t);
     eat(t, ")");
@@ -6,6 +6,10 @@
 #include <string>
 #include <vector>
 
+#include "generic/line_buffer.h"
+#include "generic/source.h"
+
+class BuildCache;
 class Token;
 class JackTokenizer;
 enum class TokenType;
@@ -24,17 +28,36 @@ class ExpressionList;
 
 class JackBuilder {
 public:
+  // builds inputFile and writes the result next to it.
   virtual void build(const std::string &inputFile) = 0;
+  // builds inputFile ("-" for stdin) and hands back the result.
+  virtual LineBuffer getResult(const std::string &inputFile) = 0;
+  // getResult(), or what it gave last time for the same input.
+  LineBuffer getCachedResult(const std::string &inputFile);
+  // options are part of the keys, see BuildCache::salt().
+  void setCache(BuildCache *cache, const std::string &options);
   virtual ~JackBuilder();
 protected:
   JackBuilder();
+  // what the builder makes, for keying the cache.
+  virtual std::string cacheStage() = 0;
+  // indexes the lines of source, timed as the read phase.
+  const LineIndex& readSource(SourceBuffer &source);
+  void write(const LineBuffer&, const std::string &outputFile);
+private:
+  BuildCache *_cache;
+  std::string _cacheOptions;
 };
 
 class JackCompilationEngineBuilder: public JackBuilder {
 public:
   JackCompilationEngineBuilder();
   virtual void build(const std::string &inputFile) override;
-  void build(JackTokenizer&, std::ostream&);
+  virtual LineBuffer getResult(const std::string &inputFile) override;
+  // same, for a file that was already read.
+  LineBuffer compileSource(SourceBuffer &source);
+  // vm code of a class already in memory.
+  LineBuffer compile(const LineIndex &lines);
   ClassElement buildClass(JackTokenizer&);
   std::vector<ClassVarDec> buildClassVarDecs(JackTokenizer&);
   std::vector<SubroutineDec> buildSubroutineDecs(JackTokenizer&, std::string className="");
@@ -47,6 +70,8 @@ public:
   SubroutineCall buildSubroutineCall(JackTokenizer &t);
   SubroutineCall buildSubroutineCall(JackTokenizer &t, Token tok);
   ExpressionList buildExpressionList(JackTokenizer &t);
+protected:
+  virtual std::string cacheStage() override;
 private:
   Token eat(JackTokenizer&);
   Token eat(JackTokenizer&, std::function<bool(Token)>);
@@ -64,6 +89,9 @@ class JackTokenizerBuilder: public JackBuilder {
 public:
   JackTokenizerBuilder();
   virtual void build(const std::string &inputFile) override;
+  virtual LineBuffer getResult(const std::string &inputFile) override;
+protected:
+  virtual std::string cacheStage() override;
 private:
   std::string _outputFile;
 };
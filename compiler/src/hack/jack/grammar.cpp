@@ -7,6 +7,7 @@
 #include <utility>
 #include <vector>
 
+#include "generic/trace.h"
 #include "generic/utils.h"
 
 #include "./grammar.h"
@@ -454,8 +455,8 @@ std::vector<std::string> Statement::toVMCode(SymbolTable &table) const {
       });
     }
   } else if (_type.value() == "if") {
-    std::string L1 = VMCommands::UniqueLabel("IF_FALSE");
-    std::string L2 = VMCommands::UniqueLabel("IF_TRUE");
+    std::string L1 = VMCommands::UniqueLabel("IF_FALSE", table.nextLabelId());
+    std::string L2 = VMCommands::UniqueLabel("IF_TRUE", table.nextLabelId());
 
     concat(code, {
       _expressions[0].toVMCode(table),
@@ -469,8 +470,8 @@ std::vector<std::string> Statement::toVMCode(SymbolTable &table) const {
       { VMCommands::Label(L2) },
     });
   } else if (_type.value() == "while") {
-    std::string L1 = VMCommands::UniqueLabel("WHILE_EXP");
-    std::string L2 = VMCommands::UniqueLabel("WHILE_END");
+    std::string L1 = VMCommands::UniqueLabel("WHILE_EXP", table.nextLabelId());
+    std::string L2 = VMCommands::UniqueLabel("WHILE_END", table.nextLabelId());
 
     concat(code, {
       { VMCommands::Label(L1) },
@@ -740,6 +741,7 @@ std::string ClassElement::getName() const { return className; }
 std::vector<std::string> ClassElement::toVMCode(SymbolTable &table) const {
   std::vector<std::string> code;
   for (const SubroutineDec &subroutine: getSubroutineDecs()) {
+    TraceSpan span("codegen", className + "." + subroutine.getName());
     // fill table with current class & subroutine we're on.
     table.init(*this, subroutine);
     std::vector<std::string> subroutineCode = subroutine.toVMCode(table);
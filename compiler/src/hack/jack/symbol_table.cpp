@@ -57,7 +57,7 @@ std::ostream& operator<<(std::ostream &out, const Symbol &s) {
 
 // SymbolTable
 
-SymbolTable::SymbolTable() { }
+SymbolTable::SymbolTable(): _labelId(0) { }
 
 SymbolTable::~SymbolTable() { reset(); }
 
@@ -163,3 +163,5 @@ std::string SymbolTable::getCurrentSubroutineKind() const {
 std::string SymbolTable::getCurrentClassName() const {
   return _className;
 }
+
+int SymbolTable::nextLabelId() { return _labelId++; }
@@ -55,6 +55,9 @@ public:
   int count(SymbolKind) const;
   std::string getCurrentSubroutineKind() const;
   std::string getCurrentClassName() const;
+  // labels are numbered per class, so a class always compiles
+  // to the same code no matter what got compiled before it.
+  int nextLabelId();
 private:
   void reset();
   void defineClassVar(std::string name, std::string type, SymbolKind kind);
@@ -69,6 +72,7 @@ private:
   std::unordered_map<SymbolKind, int, EnumClassHash> _indices;
   const SubroutineDec *_subroutine;
   const ClassElement *_classElement;
+  int _labelId;
 };
 
 #endif
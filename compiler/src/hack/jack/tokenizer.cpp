@@ -4,6 +4,7 @@
 #include <iostream>
 #include <stdexcept>
 
+#include "generic/stats.h"
 #include "generic/utils.h"
 
 #include "./tokenizer.h"
@@ -19,16 +20,19 @@ std::unordered_set<std::string> JackTokenizer::KEYWORDS = {
 };
 
 std::string JackTokenizer::IGNORE_CHARS = " \t\n\r";
+std::string JackTokenizer::DELIMITERS = IGNORE_CHARS + SYMBOLS;
 std::string JackTokenizer::SINGLE_LINE_COMMENT = "//";
 std::string JackTokenizer::MULTILINE_COMMENT_BEGIN = "/*";
 std::string JackTokenizer::MULTILINE_COMMENT_END = "*/";
 
-JackTokenizer::JackTokenizer(std::istream &in): _istream(in), _hasMore(true), _inMultiLineComment(false), _lineNo(0) {
-  if (!_istream) {
+JackTokenizer::JackTokenizer(std::istream &in): _istream(&in), _lines(nullptr), _nextLine(0), _hasMore(true), _inMultiLineComment(false), _lineNo(0) {
+  if (!*_istream) {
     std::cerr << "Input stream in tokenizer failed.\n";
   }
 }
 
+JackTokenizer::JackTokenizer(const LineIndex &lines): _istream(nullptr), _lines(&lines), _nextLine(0), _hasMore(true), _inMultiLineComment(false), _lineNo(0) { }
+
 JackTokenizer::~JackTokenizer() { }
 
 bool JackTokenizer::hasMore() {
@@ -36,18 +40,19 @@ bool JackTokenizer::hasMore() {
     return true;
 
   // try refilling the buffer until we reach eof
+  PhaseTimer timer(Phase::TOKENIZE);
   while (_crt_buffer.empty() && _hasMore) {
-    std::string line;
-    std::getline(_istream, line);
+    std::string_view line;
+    _hasMore = readLine(line);
     ++_lineNo;
+    Stats::addWork(Phase::TOKENIZE, 1);
 
     if (!line.empty())
       tokenizeLine(line, _crt_buffer);
-
-    if (!_istream || _istream.eof()) {
-      _hasMore = false;
-    }
   }
+  // the parser goes through every token, that's its work.
+  Stats::count(Counter::TOKENS, _crt_buffer.size());
+  Stats::addWork(Phase::PARSE, _crt_buffer.size());
 
   return !_crt_buffer.empty();
 }
@@ -62,48 +67,61 @@ Token JackTokenizer::getCurrentToken() {
 }
 
 void JackTokenizer::rewind() {
-  _istream.seekg(0);
+  if (_istream)
+    _istream->seekg(0);
+  _nextLine = 0;
   _lineNo = 0;
 }
 
+bool JackTokenizer::readLine(std::string_view &line) {
+  if (_lines) {
+    if (_nextLine >= _lines->size()) {
+      line = {};
+      return false;
+    }
+    line = (*_lines)[_nextLine++];
+    return _nextLine < _lines->size();
+  }
+  std::getline(*_istream, _readBuffer);
+  line = _readBuffer;
+  return *_istream && !_istream->eof();
+}
+
 template <typename ContainerT>
-void JackTokenizer::tokenizeLine(std::string line, ContainerT &out) {
-  strip(line, JackTokenizer::IGNORE_CHARS);
-  stripComments(line);
+void JackTokenizer::tokenizeLine(std::string_view line, ContainerT &out) {
+  line = stripComments(strip_view(line, JackTokenizer::IGNORE_CHARS));
   if (line.empty())
     return;
 
   if (std::count(line.begin(), line.end(), '"') % 2 != 0)
-    throw_and_debug("Ill formed string constants in line: " + line);
+    throw_and_debug("Ill formed string constants in line: " + std::string(line));
 
-  std::deque<std::string> temp;
+  std::vector<std::string_view> temp;
   // split the line by double quote first, to get the string constants.
   // also preserve double-quotes in split array, to be able to
   // tell when we're inside a double-quoted string constant or outside.
   split_by_any_char(temp, line, "\"", true);
-  bool in_quoted = false;
-  std::string quoted;
+  // the opening quote, while inside a string constant.
+  const char *quoteBegin = nullptr;
 
-  for (std::string &s : temp) {
+  for (std::string_view s : temp) {
     // if we found a quote, toggle if we're in quote or not currently.
     if (s == "\"") {
-      // we're in quoted string, just exiting; add it
-      if (in_quoted) {
-        out.push_back(Token::fromString("\"" + quoted + "\"", _lineNo));
+      // we're in quoted string, just exiting; add it along with
+      // both quotes, they're all views into the same line.
+      if (quoteBegin) {
+        std::string_view quoted(quoteBegin, s.data() + 1 - quoteBegin);
+        out.push_back(Token::fromString(std::string(quoted), _lineNo));
+        quoteBegin = nullptr;
       // we're not in quoted string, just entering one
       } else {
-        quoted = "";
+        quoteBegin = s.data();
       }
-      in_quoted = !in_quoted;
-    } else {
-      // remember the string for when we see the end of quotes.
-      if (in_quoted)
-        quoted = s;
-      // otherwise this string is string-constants free, so
-      // we can pass it to be parsed by the other symbols of
-      // the language and populate the out container.
-      else
-        tokenizeString(s, out);
+    // otherwise this string is string-constants free, so
+    // we can pass it to be parsed by the other symbols of
+    // the language and populate the out container.
+    } else if (!quoteBegin) {
+      tokenizeString(s, out);
     }
   }
 }
@@ -112,78 +130,66 @@ void JackTokenizer::tokenizeLine(std::string line, ContainerT &out) {
  * Parses string and adds it to the end of the given output container.
  */
 template <typename ContainerT>
-void JackTokenizer::tokenizeString(std::string line, ContainerT &out) {
+void JackTokenizer::tokenizeString(std::string_view line, ContainerT &out) {
 
-    strip(line, JackTokenizer::IGNORE_CHARS);
+    line = strip_view(line, JackTokenizer::IGNORE_CHARS);
     if (!line.empty()) {
       // split line into individual tokens and strip each one
-      std::deque<std::string> temp;
+      std::vector<std::string_view> temp;
       split_by_any_char(
         temp, line,
-        JackTokenizer::IGNORE_CHARS + JackTokenizer::SYMBOLS,
+        JackTokenizer::DELIMITERS,
         true  // preserves the chracters we split by
       );
 
       // copy each stripped-non-empty token from temp to output buffer.
-      std::for_each(
-        temp.begin(), temp.end(),
-        [&out, lineNo=this->_lineNo](std::string s) {
-          strip(s, JackTokenizer::IGNORE_CHARS);
-          if (!s.empty())
-            out.push_back(Token::fromString(s, lineNo));
-        }
-      );
+      for (std::string_view s : temp) {
+        s = strip_view(s, JackTokenizer::IGNORE_CHARS);
+        if (!s.empty())
+          out.push_back(Token::fromString(std::string(s), _lineNo));
+      }
     }
 }
 
-void JackTokenizer::stripComments(std::string &line) {
+std::string_view JackTokenizer::stripComments(std::string_view line) {
   /* if in multi-line comment already, look for an ending */
   if (_inMultiLineComment) {
-    auto end = std::search(
-      line.begin(), line.end(),
-      MULTILINE_COMMENT_END.begin(), MULTILINE_COMMENT_END.end()
-    );
+    size_t end = line.find(MULTILINE_COMMENT_END);
 
     // we exited a multi-line comment just now.
-    if (end != line.end())
-      _inMultiLineComment = false;
-
-    end = std::min(end + MULTILINE_COMMENT_END.size(), line.end());
-    line.erase(line.begin(), end);
+    if (end == std::string_view::npos)
+      return {};
+    _inMultiLineComment = false;
+    line.remove_prefix(end + MULTILINE_COMMENT_END.size());
   }
 
   if (line.empty())
-    return;
+    return line;
 
   /* we're not in multiline, but might just enter in one. */
-  auto begin = std::search(
-    line.begin(), line.end(),
-    MULTILINE_COMMENT_BEGIN.begin(), MULTILINE_COMMENT_BEGIN.end()
-  );
-  auto end = std::search(
-    line.begin(), line.end(),
-    MULTILINE_COMMENT_END.begin(), MULTILINE_COMMENT_END.end()
-  );
+  size_t begin = line.find(MULTILINE_COMMENT_BEGIN);
+  size_t end = line.find(MULTILINE_COMMENT_END);
 
-  if (end != line.end() && begin == line.end())
+  if (end != std::string_view::npos && begin == std::string_view::npos)
     throw_and_debug("Can't have end of multiline comment w/o corresponding start.");
 
-  if (begin != line.end())
-    _inMultiLineComment = true;
-  if (end != line.end())
-    _inMultiLineComment = false;
-
-  end = std::min(end + MULTILINE_COMMENT_END.size(), line.end());
-  line.erase(begin, end);
+  if (begin != std::string_view::npos) {
+    if (end == std::string_view::npos) {
+      _inMultiLineComment = true;
+      line = line.substr(0, begin);
+    } else {
+      // a comment in the middle of the line is the only case where
+      // the code left isn't contiguous anymore.
+      _commentBuffer.assign(line.substr(0, begin));
+      _commentBuffer.append(line.substr(end + MULTILINE_COMMENT_END.size()));
+      line = _commentBuffer;
+    }
+  }
 
   // look for single-line comment if we're not currently in a multi-line one.
-  if (!_inMultiLineComment) {
-    auto begin = std::search(
-      line.begin(), line.end(),
-      SINGLE_LINE_COMMENT.begin(), SINGLE_LINE_COMMENT.end()
-    );
-    line.erase(begin, line.end());
-  }
+  if (!_inMultiLineComment)
+    line = line.substr(0, line.find(SINGLE_LINE_COMMENT));
+  return line;
 }
 
 // Token class related
@@ -208,17 +214,16 @@ Token Token::fromString(const std::string &value, int lineNo) {
       JackTokenizer::SYMBOLS.find(value) != std::string::npos)
         return Token(TokenType::SYMBOL, value, lineNo);
 
-  if (isNumber(value)) {
-    int n = getNumber(value);
-    if (n >= 0 && n <= 32767)
-      return Token(TokenType::INT_CONSTANT, value, lineNo);
+  ParsedNumber n = parseNumber(value, 0, 32767);
+  if (n.ok())
+    return Token(TokenType::INT_CONSTANT, value, lineNo);
+  if (n.error == NumberError::OUT_OF_RANGE)
     throw_and_debug("Number out of 16-bit range: " + value);
-  }
 
-  if (value.front() == '_' || std::isalpha(value.front()))
+  if (value.front() == '_' || std::isalpha(static_cast<unsigned char>(value.front())))
     if (std::all_of(
           value.begin(), value.end(),
-          [](char c) { return c == '_' || std::isalnum(c); }))
+          [](unsigned char c) { return c == '_' || std::isalnum(c); }))
       return Token(TokenType::IDENTIFIER, value, lineNo);
 
   throw_and_debug("Unkown token type for value '" + value + "'");
@@ -252,7 +257,7 @@ std::string Token::value() const { return rawValue; }
 
 std::string Token::escapedValue() const {
   if (type == TokenType::STR_CONSTANT)
-    return strip_copy(rawValue, "\"");
+    return std::string(strip_view(rawValue, "\""));
 
   // some escaped characters
   std::string val = value();
@@ -5,9 +5,12 @@
 #include <iostream>
 #include <istream>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
+#include "generic/source.h"
+
 enum class TokenType {
   KEYWORD,
   SYMBOL,
@@ -64,6 +67,8 @@ private:
 class JackTokenizer {
 public:
   JackTokenizer(std::istream &in);
+  // reads lines that are already in memory, they must outlive it.
+  JackTokenizer(const LineIndex &lines);
   virtual ~JackTokenizer();
   virtual bool hasMore();
   virtual void advance();
@@ -75,18 +80,27 @@ public:
 private:
   // fills buffer
   template <typename ContainerT>
-  void tokenizeLine(std::string line, ContainerT &out);
+  void tokenizeLine(std::string_view line, ContainerT &out);
   template <typename ContainerT>
-  void tokenizeString(std::string str, ContainerT &out);
-  void stripComments(std::string& line);
+  void tokenizeString(std::string_view str, ContainerT &out);
+  // the view returned is into line, or into _commentBuffer.
+  std::string_view stripComments(std::string_view line);
+  // false once line was the last one. line is only valid until the
+  // next call.
+  bool readLine(std::string_view &line);
 private:
-  std::istream& _istream;
+  std::istream *_istream;
+  const LineIndex *_lines;
+  size_t _nextLine;
   std::deque<Token> _crt_buffer;
   bool _hasMore;
   bool _inMultiLineComment;
   int _lineNo;
+  std::string _readBuffer;  // backs lines read from _istream
+  std::string _commentBuffer;
 
   static std::string IGNORE_CHARS;
+  static std::string DELIMITERS;  // IGNORE_CHARS + SYMBOLS
   static std::string SINGLE_LINE_COMMENT;
   static std::string MULTILINE_COMMENT_BEGIN;
   static std::string MULTILINE_COMMENT_END;
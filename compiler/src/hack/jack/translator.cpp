@@ -1,6 +1,16 @@
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <list>
+#include <stdexcept>
 #include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "generic/line_buffer.h"
+#include "generic/parallel.h"
+#include "generic/utils.h"
+#include "hack/library.h"
 
 #include "./translator.h"
 #include "./tokenizer.h"
@@ -10,26 +20,101 @@ Translator* getTranslatorFromPath(const std::string &path) {
   return new JackTranslator(path);
 }
 
-JackTranslator::JackTranslator(const std::string &path): HackTranslator(path) {
-  _jack_builders = {
+JackTranslator::JackTranslator(const std::string &path): HackTranslator(path) { }
+
+JackTranslator::~JackTranslator() {
+  for (std::list<JackBuilder*> &builders: _jack_builders)
+    for (auto it = builders.begin(); it != builders.end(); ++it)
+      delete *it;
+}
+
+std::list<JackBuilder*> JackTranslator::createJackBuilders() {
+  return {
     //new JackTokenizerBuilder(),
     new JackCompilationEngineBuilder(),
   };
 }
 
-JackTranslator::~JackTranslator() {
-  for (auto it = _jack_builders.begin(); it != _jack_builders.end(); ++it)
-    delete *it;
+void JackTranslator::createJackWorkers(size_t inputs) {
+  int workers = std::max(1, std::min<int>(_jobs, inputs));
+  while (static_cast<int>(_jack_builders.size()) < workers) {
+    _jack_builders.push_back(createJackBuilders());
+    for (JackBuilder *builder: _jack_builders.back())
+      builder->setCache(_cache, cacheOptions());
+  }
+}
+
+// each .jack file compiles into its own .vm file, so they can all
+// be compiled at the same time.
+void JackTranslator::buildEach(const std::vector<std::string> &inputFiles) {
+  createJackWorkers(inputFiles.size());
+  parallelFor(inputFiles.size(), _jobs, [&](int worker, size_t i) {
+    for (JackBuilder *builder: _jack_builders[worker])
+      builder->build(inputFiles[i]);
+  });
 }
 
 void JackTranslator::translate() {
-  std::cout << "Processing " << _path << '\n';
-  for (const std::string &inputFile: getInputFiles())
-    for (JackBuilder *builder: _jack_builders)
-      builder->build(inputFile);
+  status() << "Processing " << _path << '\n';
+  std::list<std::string> inputList = getInputFiles();
+  std::vector<std::string> inputFiles(inputList.begin(), inputList.end());
+
+  if (!_libraries.empty())
+    throw std::runtime_error("Classes compile on their own, libraries get "
+                             "linked by VMTranslator or hcc\n");
+  if (!_makeLibrary.empty()) {
+    makeLibrary(inputFiles);
+    return;
+  }
+  if (_outputFile.empty() && !isStdio(_path)) {
+    buildEach(inputFiles);
+    return;
+  }
+  createJackWorkers(inputFiles.size());
+
+  // single output (-o or stdin given), classes go in it one
+  // after the other, in input order.
+  std::vector<LineBuffer> results(inputFiles.size());
+  parallelFor(inputFiles.size(), _jobs, [&](int worker, size_t i) {
+    for (JackBuilder *builder: _jack_builders[worker])
+      results[i].append(builder->getCachedResult(inputFiles[i]));
+  });
+  LineBuffer allLines;
+  for (LineBuffer &lines: results)
+    allLines.append(lines);
+  writeToFile(allLines);
+}
+
+// a vm library: VMTranslator and hcc translate it while linking.
+void JackTranslator::makeLibrary(const std::vector<std::string> &inputFiles) {
+  createJackWorkers(inputFiles.size());
+  writeLibrary(inputFiles, "vm", [&](int worker, const std::string &file,
+                                     LibraryClass &libraryClass) {
+    LineBuffer vmCode;
+    for (JackBuilder *builder: _jack_builders[worker])
+      vmCode.append(builder->getCachedResult(file));
+    scanVMSymbols(vmCode.index(), libraryClass);
+    return vmCode;
+  });
+}
+
+void JackTranslator::rebuild(const std::vector<std::string> &changed) {
+  if (changed.empty() || !_outputFile.empty()) {
+    translate();
+    return;
+  }
+  // a removed class leaves its .vm file behind, like it always did.
+  std::vector<std::string> inputFiles;
+  for (const std::string &path: changed)
+    if (access(path.c_str(), R_OK) == 0)
+      inputFiles.push_back(path);
+  buildEach(inputFiles);
 }
 
 std::string JackTranslator::extension() { return "jack"; }
 
-// unused, since we're overwriting the translate.
-std::string JackTranslator::getOutputFile() { return ""; }
+// only used with stdin, otherwise each class gets its own .vm file.
+std::string JackTranslator::getOutputFile() { return "-"; }
+
+// unused, jack builders work on tokens rather than lines.
+std::list<Builder*> JackTranslator::createBuilders() { return {}; }
@@ -3,6 +3,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include "hack/translator.h"
 
@@ -15,8 +16,18 @@ public:
   virtual void translate() override;
   virtual std::string extension() override;
   virtual std::string getOutputFile() override;
+protected:
+  virtual std::list<Builder*> createBuilders() override;
+  std::list<JackBuilder*> createJackBuilders();
+  // only the classes that changed, when each gets its own .vm file.
+  virtual void rebuild(const std::vector<std::string> &changed) override;
+  virtual void makeLibrary(const std::vector<std::string> &inputFiles) override;
 private:
-  std::list<JackBuilder*> _jack_builders;
+  void createJackWorkers(size_t inputs);
+  // compiles each file into a .vm file next to it.
+  void buildEach(const std::vector<std::string> &inputFiles);
+private:
+  std::vector<std::list<JackBuilder*>> _jack_builders;  // one list per worker
 };
 
 #endif
@@ -1,4 +1,6 @@
 #include <string>
+#include <string_view>
+#include <utility>
 
 #include "generic/utils.h"
 
@@ -10,13 +12,12 @@ const std::vector<std::string> VMCommands::Segments = {
   "that", "static", "temp", "pointer"
 };
 
-std::string VMCommands::UniqueLabel(std::string prefix) {
-  static int n = 0;
-  return prefix + toString(n++);
+std::string VMCommands::UniqueLabel(std::string prefix, int id) {
+  return withNumber(std::move(prefix), id);
 }
 
 std::string VMCommands::Function(std::string name, int nLocals) {
-  return "function " + name + " " + toString(nLocals);
+  return withNumber("function " + name + " ", nLocals);
 }
 
 std::string VMCommands::ArithmeticLogic(std::string name) { return name; }
@@ -46,28 +47,34 @@ std::string VMCommands::IfGoto(std::string label) { return "if-goto " + label; }
 
 std::string VMCommands::Label(std::string label) { return "label " + label; }
 
-std::string VMCommands::Push(std::string segment, std::string val) {
+std::string VMCommands::Push(std::string segment, std::string_view val) {
   if (!in_array(segment, Segments))
     throw_and_debug("Invalid segment " + segment);
-  return "push " + segment + " " + val;
+  std::string command = "push " + segment + " ";
+  command.append(val);
+  return command;
 }
 
 std::string VMCommands::Push(std::string segment, int val) {
-  return Push(segment, toString(val));
+  NumberBuffer buf;
+  return Push(segment, formatNumber(val, buf));
 }
 
-std::string VMCommands::Pop(std::string segment, std::string val) {
+std::string VMCommands::Pop(std::string segment, std::string_view val) {
   if (!in_array(segment, Segments))
     throw_and_debug("Invalid segment " + segment);
-  return "pop " + segment + " " + val;
+  std::string command = "pop " + segment + " ";
+  command.append(val);
+  return command;
 }
 
 std::string VMCommands::Pop(std::string segment, int val) {
-  return Pop(segment, toString(val));
+  NumberBuffer buf;
+  return Pop(segment, formatNumber(val, buf));
 }
 
 std::string VMCommands::Return() { return "return"; }
 
 std::string VMCommands::Call(std::string name, int nArgs) {
-  return "call " + name + " " + toString(nArgs);
+  return withNumber("call " + name + " ", nArgs);
 }
@@ -3,13 +3,14 @@
 
 #include <cstdio>
 #include <string>
+#include <string_view>
 
 enum class Op;
 enum class UnaryOp;
 
 class VMCommands {
 public:
-  static std::string UniqueLabel(std::string prefix="L");
+  static std::string UniqueLabel(std::string prefix, int id);
   static std::string Function(std::string name, int nLocals);
   static std::string ArithmeticLogic(std::string name);
   static std::string ArithmeticLogic(Op);
@@ -17,9 +18,9 @@ public:
   static std::string Goto(std::string label);
   static std::string IfGoto(std::string label);
   static std::string Label(std::string label);
-  static std::string Push(std::string segment, std::string val);
+  static std::string Push(std::string segment, std::string_view val);
   static std::string Push(std::string segment, int val);
-  static std::string Pop(std::string segment, std::string val);
+  static std::string Pop(std::string segment, std::string_view val);
   static std::string Pop(std::string segment, int val);
   static std::string Return();
   static std::string Call(std::string name, int nArgs);
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "generic/line_buffer.h"
+#include "generic/output.h"
+#include "generic/source.h"
+#include "generic/utils.h"
+
+#include "./library.h"
+#include "./utils.h"
+
+static const std::string MAGIC = "hcc-lib 1";
+
+static std::runtime_error badLibrary(const std::string &path, size_t lineNo) {
+  return std::runtime_error(withNumber("Bad library " + path + " at line ", lineNo) + "\n");
+}
+
+// Library
+
+Library::Library(const std::string &path)
+  : _path(path), _source(new SourceBuffer(path)) {
+  const LineIndex &lines = _source->lines();
+  std::vector<std::string_view> parts;
+  split_by_any_char(parts, lines.empty() ? "" : lines[0], " ");
+  if (parts.size() != 3 || MAGIC != std::string(parts[0]) + " " + std::string(parts[1]) ||
+      (parts[2] != "vm" && parts[2] != "asm"))
+    throw std::runtime_error("Not an hcc library: " + path + "\n");
+  _stage = parts[2];
+
+  // every line ends in '\n', so the one after the last is empty.
+  size_t end = lines.size() - 1;
+  if (!lines[end].empty())
+    throw badLibrary(path, end + 1);
+  size_t i = 1;
+  while (i < end) {
+    parts.clear();
+    split_by_any_char(parts, lines[i], " ");
+    ParsedNumber count = parseNumber(parts.size() == 3 ? parts[2] : "", 0);
+    if (parts.size() != 3 || parts[0] != "class" || !count.ok())
+      throw badLibrary(path, i + 1);
+    LibraryClass libraryClass;
+    libraryClass.name = parts[1];
+    for (++i; i < end; ++i) {
+      std::string_view line = lines[i];
+      if (startsWith(line, "export "))
+        libraryClass.exports.emplace_back(line.substr(7));
+      else if (startsWith(line, "import "))
+        libraryClass.imports.emplace_back(line.substr(7));
+      else
+        break;
+    }
+    if (i + count.value > end)
+      throw badLibrary(path, i + 1);
+    if (count.value > 0) {
+      const char *start = lines[i].data();
+      std::string_view last = lines[i + count.value - 1];
+      libraryClass.code = std::string_view(start, last.data() + last.size() + 1 - start);
+    }
+    i += count.value;
+    _classes.push_back(std::move(libraryClass));
+  }
+}
+
+const std::string& Library::path() const { return _path; }
+
+const std::string& Library::stage() const { return _stage; }
+
+const std::vector<LibraryClass>& Library::classes() const { return _classes; }
+
+void Library::write(const std::string &path, const std::string &stage,
+                    const std::vector<LibraryClass> &classes) {
+  OutputSink out(path);
+  out.write(MAGIC + " " + stage + "\n");
+  for (const LibraryClass &libraryClass: classes) {
+    size_t lines = std::count(libraryClass.code.begin(), libraryClass.code.end(), '\n');
+    out.write(withNumber("class " + libraryClass.name + " ", lines) + "\n");
+    for (const std::string &name: libraryClass.exports)
+      out.write("export " + name + "\n");
+    for (const std::string &name: libraryClass.imports)
+      out.write("import " + name + "\n");
+    out.writeNoCopy(libraryClass.code);
+  }
+  out.close();
+}
+
+void scanVMSymbols(const LineIndex &vmCode, LibraryClass &libraryClass) {
+  std::set<std::string> exports;
+  std::set<std::string> calls;
+  std::vector<std::string_view> parts;
+  for (std::string_view line: vmCode) {
+    parts.clear();
+    split_by_any_char(parts, trim_view(trimComment(line)), " \t");
+    if (parts.size() < 2)
+      continue;
+    if (parts[0] == "function")
+      exports.emplace(parts[1]);
+    else if (parts[0] == "call")
+      calls.emplace(parts[1]);
+  }
+  libraryClass.exports.assign(exports.begin(), exports.end());
+  libraryClass.imports.clear();
+  for (const std::string &name: calls)
+    if (!exports.count(name))
+      libraryClass.imports.push_back(name);
+}
+
+// Linker
+
+void Linker::addLibrary(const std::string &path) {
+  _libraries.emplace_back(new Library(path));
+}
+
+void Linker::scan(const LineIndex &asmCode) {
+  for (std::string_view line: asmCode) {
+    line = trim_view(trimComment(line));
+    if (line.size() > 1 && line.front() == '@')
+      _used.emplace(line.substr(1));
+    else if (line.size() > 2 && line.front() == '(' && line.back() == ')')
+      _defined.emplace(line.substr(1, line.size() - 2));
+  }
+}
+
+void Linker::scan(const LineBuffer &asmCode) {
+  scan(asmCode.index());
+}
+
+std::vector<Linker::Needed> Linker::resolve() const {
+  // who defines each function, first library first.
+  std::map<std::string, std::pair<size_t, size_t>> definedBy;
+  for (size_t l = 0; l < _libraries.size(); ++l) {
+    const std::vector<LibraryClass> &classes = _libraries[l]->classes();
+    for (size_t c = 0; c < classes.size(); ++c)
+      for (const std::string &name: classes[c].exports)
+        definedBy.emplace(name, std::make_pair(l, c));
+  }
+
+  std::set<std::pair<size_t, size_t>> needed;
+  std::vector<std::string> wanted;
+  for (const std::string &name: _used)
+    if (!_defined.count(name))
+      wanted.push_back(name);
+  while (!wanted.empty()) {
+    std::string name = wanted.back();
+    wanted.pop_back();
+    auto it = definedBy.find(name);
+    // anything else is the program's business, e.g. a variable.
+    if (it == definedBy.end() || !needed.insert(it->second).second)
+      continue;
+    const LibraryClass &libraryClass =
+      _libraries[it->second.first]->classes()[it->second.second];
+    for (const std::string &import: libraryClass.imports)
+      if (!_defined.count(import))
+        wanted.push_back(import);
+  }
+
+  std::vector<Needed> out;
+  for (const std::pair<size_t, size_t> &n: needed)
+    out.push_back({_libraries[n.first].get(),
+                   &_libraries[n.first]->classes()[n.second]});
+  return out;
+}
@@ -0,0 +1,75 @@
+#ifndef __HACK__LIBRARY__H__
+#define __HACK__LIBRARY__H__
+
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "generic/line_buffer.h"
+#include "generic/source.h"
+
+// One class of a library: its code, already translated to the
+// library's stage, and the functions it defines and calls.
+struct LibraryClass {
+  std::string name;
+  std::vector<std::string> exports;
+  // calls to functions it doesn't define itself.
+  std::vector<std::string> imports;
+  // whole lines, each ending in '\n'.
+  std::string_view code;
+};
+
+// A library (.hlib) bundles classes translated once, e.g. the OS, so
+// programs link them instead of translating them every time. It's
+// text, a header line and then a section per class:
+//
+//   hcc-lib 1 asm            (or vm)
+//   class Math 1234          (name and lines of code)
+//   export Math.multiply     (one per function defined)
+//   import Memory.alloc      (one per function called elsewhere)
+//   ...the 1234 lines of code
+class Library {
+public:
+  Library(const std::string &path);
+  const std::string& path() const;
+  // "vm" or "asm", what the code of every class is.
+  const std::string& stage() const;
+  const std::vector<LibraryClass>& classes() const;
+
+  static void write(const std::string &path, const std::string &stage,
+                    const std::vector<LibraryClass> &classes);
+private:
+  std::string _path;
+  std::string _stage;
+  std::unique_ptr<SourceBuffer> _source;  // the code points into it
+  std::vector<LibraryClass> _classes;
+};
+
+// exports and imports of a class, out of its vm code.
+void scanVMSymbols(const LineIndex &vmCode, LibraryClass &libraryClass);
+
+// Picks the library classes a program needs: the ones defining what
+// it references but doesn't define, then what those reference, and
+// so on. The first library (in the order added) defining a function
+// is the one used.
+class Linker {
+public:
+  void addLibrary(const std::string &path);
+  // notes the labels asm code defines and the symbols it uses.
+  void scan(const LineIndex &asmCode);
+  void scan(const LineBuffer &asmCode);
+  struct Needed {
+    const Library *library;
+    const LibraryClass *libraryClass;
+  };
+  // in library order, so the same program always links the same.
+  std::vector<Needed> resolve() const;
+private:
+  std::vector<std::unique_ptr<Library>> _libraries;
+  std::set<std::string> _defined;
+  std::set<std::string> _used;
+};
+
+#endif
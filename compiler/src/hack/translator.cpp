@@ -1,37 +1,260 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <iostream>
 #include <list>
+#include <memory>
 #include <string>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
+#include "generic/line_buffer.h"
+#include "generic/output.h"
+#include "generic/parallel.h"
+#include "generic/pipeline.h"
+#include "generic/source.h"
+#include "generic/stats.h"
+#include "generic/trace.h"
 #include "generic/translator.h"
 #include "generic/utils.h"
+#include "generic/watch.h"
 
 #include "./translator.h"
 #include "./utils.h"
 
 HackTranslator::HackTranslator(const std::string &path)
-  : Translator(path) {}
+  : Translator(path), _format(HackFormat::TEXT) {}
+
+void HackTranslator::setFormat(const std::string &format) {
+  if (outputsHack())
+    _format = parseHackFormat(format);
+  else
+    Translator::setFormat(format);
+}
 
 void HackTranslator::translate() {
-  std::list<std::string> allLines;
-  const std::list<std::string> *crtLines;
-  for (const std::string &inputFile: getInputFiles()) {
-    std::cout << "Translating single file " << inputFile << "\n";
-    crtLines = translateFile(inputFile);
-    debug("Got back", crtLines->size(), "lines");
-    std::copy(
-      crtLines->cbegin(), crtLines->cend(),
-      std::back_inserter(allLines)
-    );
+  std::list<std::string> inputList = getInputFiles();
+  std::vector<std::string> inputFiles(inputList.begin(), inputList.end());
+  if (!_makeLibrary.empty()) {
+    makeLibrary(inputFiles);
+    return;
+  }
+  // the other formats need all the words before writing any.
+  if (_pipeline && _format == HackFormat::TEXT) {
+    translatePipelined(inputFiles);
+    return;
+  }
+  std::vector<LineBuffer> results(inputFiles.size());
+
+  // files are independent of each other until they get concatenated,
+  // in the same order as a serial run would.
+  createWorkers(std::max(1, std::min<int>(_jobs, inputFiles.size())));
+  parallelFor(inputFiles.size(), _jobs, [&](int worker, size_t i) {
+    status() << "Translating single file " + inputFiles[i] + "\n";
+    results[i] = translateFile(inputFiles[i], worker);
+    debug("Got back", results[i].size(), "lines");
+  });
+
+  LineBuffer allLines;
+  for (LineBuffer &crtLines: results) {
+    // first file is taken over as is, the rest get appended in bulk.
+    if (allLines.empty())
+      allLines = std::move(crtLines);
+    else
+      allLines.append(crtLines);
     // insert empty line between them.
     allLines.push_back("");
   }
   beforeWriteToFile(allLines);
+  if (!_libraries.empty() && linksOutput()) {
+    Linker linker = createLinker();
+    linker.scan(allLines);
+    allLines.append(linkLibraries(linker));
+  }
   writeToFile(allLines);
 }
 
+void HackTranslator::translatePipelined(const std::vector<std::string> &inputFiles) {
+  int jobs = std::max(1, std::min<int>(_jobs, inputFiles.size()));
+  createWorkers(jobs);
+  std::string outputFile = resolveOutputFile();
+  status() << "Translating " << _path << " into " << outputFile << "\n";
+
+  // nothing shows up at outputFile unless all of it got translated,
+  // same as when it's written at the end.
+  std::string tmpFile = isStdio(outputFile) ? outputFile : outputFile + ".tmp";
+  try {
+    Linker linker = createLinker();
+    OutputSink out(tmpFile);
+    LineBuffer start = header();
+    Stats::count(Counter::LINES_OUT, start.size());
+    out.write(start.text());
+    bool link = !_libraries.empty() && linksOutput();
+    if (link)
+      linker.scan(start);
+
+    // a couple of files per worker keep all of them busy, without
+    // holding much more than what's being translated.
+    pipeline<std::unique_ptr<SourceBuffer>, LineBuffer>(
+      inputFiles.size(), jobs, 2 * jobs,
+      [&](size_t i) {
+        status() << "Translating single file " + inputFiles[i] + "\n";
+        TraceSpan span("pass", phaseName(Phase::READ));
+        PhaseTimer timer(Phase::READ);
+        std::unique_ptr<SourceBuffer> source(new SourceBuffer(inputFiles[i]));
+        source->lines();
+        return source;
+      },
+      [&](int worker, size_t i, std::unique_ptr<SourceBuffer> &source) {
+        TraceSpan fileSpan("file", inputFiles[i]);
+        LineBuffer lines = translateSource(inputFiles[i], *source, worker);
+        source.reset();
+        return lines;
+      },
+      [&](size_t, LineBuffer &lines) {
+        TraceSpan span("pass", phaseName(Phase::WRITE));
+        PhaseTimer timer(Phase::WRITE);
+        // an empty line after every file, like the serial version.
+        Stats::count(Counter::LINES_OUT, lines.size() + 1);
+        Stats::addWork(Phase::WRITE, lines.text().size() + 1);
+        out.write(lines.text());
+        out.write("\n");
+        if (link)
+          linker.scan(lines);
+      });
+    if (link) {
+      LineBuffer linked = linkLibraries(linker);
+      Stats::count(Counter::LINES_OUT, linked.size());
+      out.write(linked.text());
+    }
+    out.close();
+  } catch (...) {
+    if (tmpFile != outputFile)
+      std::remove(tmpFile.c_str());
+    throw;
+  }
+  if (tmpFile != outputFile && std::rename(tmpFile.c_str(), outputFile.c_str()) != 0)
+    throw std::runtime_error("Cannot write to " + outputFile + "\n");
+}
+
+void HackTranslator::watch() {
+  if (isStdio(_path))
+    throw std::runtime_error("Cannot watch stdin\n");
+  // set up before the first build, so no change goes unnoticed.
+  Watcher watcher(_path, extension());
+  std::vector<std::string> changed;
+  for (;;) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+      rebuild(changed);
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      status() << "Built in " << std::chrono::duration<double, std::milli>(elapsed).count()
+               << " ms, watching " << _path << '\n' << std::flush;
+    } catch (std::exception &e) {
+      // keep going, the next save probably fixes it.
+      // not every message ends in a newline, jack parser ones don't.
+      status() << rstrip_copy(e.what(), "\n") << '\n'
+               << "Watching " << _path << '\n' << std::flush;
+    }
+    changed = watcher.wait();
+  }
+}
+
+void HackTranslator::makeLibrary(const std::vector<std::string>&) {
+  throw std::runtime_error("This tool doesn't make libraries, JackCompiler "
+                           "and VMTranslator do\n");
+}
+
+void HackTranslator::writeLibrary(
+    const std::vector<std::string> &inputFiles, const std::string &stage,
+    const std::function<LineBuffer(int worker, const std::string &file,
+                                   LibraryClass&)> &translate) {
+  if (isStdio(_path))
+    throw std::runtime_error("Cannot make a library out of stdin\n");
+  std::vector<LineBuffer> code(inputFiles.size());
+  std::vector<LibraryClass> classes(inputFiles.size());
+  parallelFor(inputFiles.size(), _jobs, [&](int worker, size_t i) {
+    status() << "Translating single file " + inputFiles[i] + "\n";
+    classes[i].name = getStem(inputFiles[i]);
+    code[i] = translate(worker, inputFiles[i], classes[i]);
+    classes[i].code = code[i].text();
+  });
+  status() << "Writing library " << _makeLibrary << '\n';
+  Library::write(_makeLibrary, stage, classes);
+}
+
+Linker HackTranslator::createLinker() {
+  Linker linker;
+  for (const std::string &path: _libraries)
+    linker.addLibrary(path);
+  return linker;
+}
+
+LineBuffer HackTranslator::linkLibraries(const Linker &linker) {
+  LineBuffer linked;
+  for (const Linker::Needed &needed: linker.resolve()) {
+    const LibraryClass &libraryClass = *needed.libraryClass;
+    status() << "Linking " << libraryClass.name << " from "
+             << needed.library->path() << '\n';
+    if (needed.library->stage() == "asm") {
+      linked.appendText(libraryClass.code);
+    } else if (linksVM()) {
+      // same as if the class had been one of the inputs.
+      LineIndex vmLines;
+      indexLines(vmLines, libraryClass.code);
+      linked.append(runBuilders(getBuilders(0), vmLines, libraryClass.name + ".vm"));
+    } else {
+      throw std::runtime_error(needed.library->path() + " holds vm code, " +
+                               "only asm libraries can be linked here\n");
+    }
+    linked.push_back("");
+  }
+  return linked;
+}
+
+bool HackTranslator::linksOutput() { return true; }
+
+bool HackTranslator::linksVM() { return false; }
+
+void HackTranslator::writeWords(const std::vector<uint16_t> &words) {
+  std::string outputFile = resolveOutputFile();
+  status() << "Translating " << _path << " into "
+           << outputFile << "\n";
+  writeHack(words, _format, outputFile);
+}
+
+std::string HackTranslator::programFile(const std::string &ext) {
+  if (isStdio(_path))
+    return _path;
+  PathType pathType = getPathType(_path);
+  if (pathType == PathType::REG_FILE_TYPE)
+    return replaceExtension(_path, ext);
+  else if (pathType == PathType::DIR_TYPE)
+    // all files go into a dirname/<dirname>.<ext> one
+    return joinPaths(_path, getFilename(_path) + "." + ext);
+
+  throw std::runtime_error("Not implemented logic for other file types");
+}
+
+bool HackTranslator::outputsHack() { return false; }
+
+LineBuffer HackTranslator::header() { return LineBuffer(); }
+
+void HackTranslator::beforeWriteToFile(LineBuffer &lines) {
+  LineBuffer start = header();
+  if (!start.empty())
+    lines.prepend(start);
+}
+
 std::list<std::string> HackTranslator::getInputFiles() {
   std::list<std::string> output;
+  if (isStdio(_path)) {
+    output.push_back(_path);
+    return output;
+  }
+
   PathType pathType = getPathType(_path);
 
   if (pathType == PathType::REG_FILE_TYPE) {
@@ -41,6 +264,9 @@ std::list<std::string> HackTranslator::getInputFiles() {
   } else if (pathType == PathType::DIR_TYPE) {
     std::vector<std::string> files;
     getDirFiles(files, _path);
+    // readdir order is arbitrary; sorted, a directory always builds
+    // the same, and tools after one another see classes in the same order.
+    std::sort(files.begin(), files.end());
     for (const std::string &f : files)
       if (getExtension(f) == extension())
         output.push_back(joinPaths(_path, f));
@@ -1,20 +1,68 @@
 #ifndef __HACK_TRANSLATOR__H__
 #define __HACK_TRANSLATOR__H__
 
+#include <cstdint>
+#include <functional>
 #include <list>
 #include <string>
+#include <vector>
 
+#include "generic/line_buffer.h"
 #include "generic/translator.h"
+#include "./format.h"
+#include "./library.h"
 
 class HackTranslator: public Translator {
 public:
   // adds directory loop logic, to bundle multiple files
   // into one output file.
   virtual void translate();
+  // watches the input files (the directory, or the single file) and
+  // rebuilds whenever they change; errors don't stop the watching.
+  virtual void watch() override;
+  // text, bin, hex or rom, for tools writing hack code.
+  virtual void setFormat(const std::string &format) override;
 protected:
   HackTranslator(const std::string &path);  // abstract
   virtual std::list<std::string> getInputFiles();
   virtual std::string extension() = 0;
+  // code going before all the files, none by default.
+  virtual LineBuffer header();
+  virtual void beforeWriteToFile(LineBuffer&) override;
+  // whether the output is hack code, which can be written in any
+  // HackFormat; everything else is text.
+  virtual bool outputsHack();
+  // where the output with the given extension goes for a whole
+  // program: next to a single file, or dir/<dir>.<ext> for a directory.
+  std::string programFile(const std::string &ext);
+  // writeToFile() for formats other than TEXT, given the assembler's
+  // words instead of lines.
+  void writeWords(const std::vector<uint16_t> &words);
+
+  // --make-lib: bundles the inputs into a library, if the tool can.
+  virtual void makeLibrary(const std::vector<std::string> &inputFiles);
+  // translate() gives a class' code and fills in its symbols.
+  void writeLibrary(const std::vector<std::string> &inputFiles,
+                    const std::string &stage,
+                    const std::function<LineBuffer(int worker, const std::string &file,
+                                                   LibraryClass&)> &translate);
+  // a linker over the libraries given with addLibrary().
+  Linker createLinker();
+  // asm code of the library classes needed by what linker scanned,
+  // an empty line after each, like after every input file.
+  LineBuffer linkLibraries(const Linker &linker);
+  // whether libraries get linked into the program the inputs translate
+  // to; if not, the tool links them into the inputs itself.
+  virtual bool linksOutput();
+  // whether vm libraries get translated while linking; asm ones are
+  // linked as they are.
+  virtual bool linksVM();
+protected:
+  HackFormat _format;
+private:
+  // --pipeline: files stream from a reader thread through the workers
+  // to the output, instead of all of them being held until the end.
+  void translatePipelined(const std::vector<std::string> &inputFiles);
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <string>
+#include <string_view>
 
 #include "./utils.h"
 
@@ -11,6 +12,10 @@ std::string trimComment(const std::string &line, const std::string &comment) {
   return trimmed;
 }
 
+std::string_view trimComment(std::string_view line, std::string_view comment) {
+  return line.substr(0, line.find(comment));
+}
+
 std::string getComment(const std::string &line, const std::string &comment) {
   return comment + " " + line;
 }
@@ -2,8 +2,11 @@
 #define __HACK__UTILS__H__
 
 #include <string>
+#include <string_view>
 
 std::string trimComment(const std::string &line, const std::string &comment="//");
+// non-copying version, the view returned points into line.
+std::string_view trimComment(std::string_view line, std::string_view comment="//");
 std::string getComment(const std::string&, const std::string &comment="//");
 
 #endif
@@ -2,7 +2,9 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
+#include "generic/stats.h"
 #include "generic/utils.h"
 #include "hack/utils.h"
 
@@ -10,76 +12,83 @@
 #include "./builder.h"
 
 HackBuilderVMTranslator::HackBuilderVMTranslator()
-  : Builder() { }
+  : InstructionBuilder() { }
 
 HackBuilderVMTranslator::HackBuilderVMTranslator(const std::string &filename)
-  : Builder(filename) { }
+  : InstructionBuilder(filename) { }
 
-Instruction* HackBuilderVMTranslator::parseLine(const std::string &line) {
-  std::string instr = trimComment(line);
-  trim(instr);
+void HackBuilderVMTranslator::parseLine(std::string_view line,
+                                        VMInstructions &parsed) {
+  std::string_view instr = trim_view(trimComment(line));
 
-  if (instr.empty())
-    return nullptr;
+  if (instr.empty()) {
+    parsed = std::monostate();
+    return;
+  }
 
   if (instr.substr(0, 3) == "pop" || instr.substr(0, 4) == "push") {
-    std::string segment = MemorySegment::parse(instr)[1];
+    std::string_view segment = MemorySegment::parse(instr)[1];
     if (segment == "constant")
-      return new ConstantMemorySegment(instr);
-    else if (SegmentBaseMemorySegment::canHandleSegment(segment))
-      return new SegmentBaseMemorySegment(instr);
+      return place<ConstantMemorySegment>(parsed, instr);
+    else if (SegmentBaseMemorySegment::canHandleSegment(std::string(segment)))
+      return place<SegmentBaseMemorySegment>(parsed, instr);
     else if (segment == "temp")
-      return new TempMemorySegment(instr);
+      return place<TempMemorySegment>(parsed, instr);
     else if (segment == "pointer")
-      return new PointerMemorySegment(instr);
+      return place<PointerMemorySegment>(parsed, instr);
     else if (segment == "static")
-      return new StaticMemorySegment(instr);
+      return place<StaticMemorySegment>(parsed, instr);
 
-    throw std::runtime_error("Unknown instruction " + instr + "\n");
+    throw std::runtime_error("Unknown instruction " + std::string(instr) + "\n");
   }
 
   if (ArithmeticLogic::isArithmeticLogicOp(instr)) {
     if (instr == "add")
-      return new AddArithmeticLogic(instr);
+      return place<AddArithmeticLogic>(parsed, instr);
     else if (instr == "sub")
-      return new SubArithmeticLogic(instr);
+      return place<SubArithmeticLogic>(parsed, instr);
     else if (instr == "neg")
-      return new NegArithmeticLogic(instr);
+      return place<NegArithmeticLogic>(parsed, instr);
     else if (instr == "eq")
-      return new EqArithmeticLogic(instr);
+      return place<EqArithmeticLogic>(parsed, instr);
     else if (instr == "gt")
-      return new GtArithmeticLogic(instr);
+      return place<GtArithmeticLogic>(parsed, instr);
     else if (instr == "lt")
-      return new LtArithmeticLogic(instr);
+      return place<LtArithmeticLogic>(parsed, instr);
     else if (instr == "and")
-      return new AndArithmeticLogic(instr);
+      return place<AndArithmeticLogic>(parsed, instr);
     else if (instr == "or")
-      return new OrArithmeticLogic(instr);
+      return place<OrArithmeticLogic>(parsed, instr);
     else if (instr == "not")
-      return new NotArithmeticLogic(instr);
+      return place<NotArithmeticLogic>(parsed, instr);
     else
-      throw std::runtime_error("Unknown instruction " + instr + "\n");
+      throw std::runtime_error("Unknown instruction " + std::string(instr) + "\n");
   }
 
   // branching instructions
   if (startsWith(instr, "label")) {
-    return new LabelInstruction(instr);
+    return place<LabelInstruction>(parsed, instr);
   } else if (startsWith(instr, "goto")) {
-    return new GotoInstruction(instr);
+    return place<GotoInstruction>(parsed, instr);
   } else if (startsWith(instr, "if-goto")) {
-    return new IfGotoInstruction(instr);
+    return place<IfGotoInstruction>(parsed, instr);
   }
 
   // function instructions
   if (startsWith(instr, "function")) {
-    return new FunctionInstruction(instr);
+    return place<FunctionInstruction>(parsed, instr);
   } else if (instr == "return") {
-    return new ReturnInstruction(instr);
+    return place<ReturnInstruction>(parsed, instr);
   } else if (startsWith(instr, "call")) {
-    return new CallInstruction(instr);
+    return place<CallInstruction>(parsed, instr);
   }
 
-  throw std::runtime_error("Not supported instruction " + instr + "\n");
+  throw std::runtime_error("Not supported instruction " + std::string(instr) + "\n");
+}
+
+void HackBuilderVMTranslator::processLines(const LineIndex *lines) {
+  output.push_back(getComment("file: " + ::getFilename(getFilename())));
+  InstructionBuilder::processLines(lines);
 }
 
 void HackBuilderVMTranslator::visit(MemorySegment *i) {
@@ -93,11 +102,14 @@ void HackBuilderVMTranslator::visit(ArithmeticLogic *i) {
 
 void HackBuilderVMTranslator::visit(BranchingInstruction *i) {
   HackBuilderVMTranslator::defaultVisit(i);
+  if (Stats::enabled() && i->cmd() == "label")
+    Stats::count(Counter::LABELS);
   debug("in branch instr visit:", i->toString());
 }
 
 void HackBuilderVMTranslator::visit(FunctionInstruction *i) {
   HackBuilderVMTranslator::defaultVisit(i);
+  Stats::count(Counter::LABELS);
   debug("in function visit:", i->name(), "nVars:", i->nVars());
   setCurrentFunction(i->name());
 }
@@ -115,6 +127,35 @@ void HackBuilderVMTranslator::visit(CallInstruction *i) {
 void HackBuilderVMTranslator::defaultVisit(VMTranslationInstruction *i) {
   // adding a comment about what generated that code is going to be
   // helpful.
-  output->push_back(getComment(i->toString()));
-  output->push_back(i->translate());
+  output.push_back(getComment(i->toString()));
+  output.push_back(i->translate());
+  Stats::count(Counter::INSTRUCTIONS);
+}
+
+LineBuffer HackBuilderVMTranslator::getBootstrapCode() {
+  // first add registers initialization
+  LineBuffer bootstrapCode;
+  for (const char *line : {
+    "// bootstrap code",
+    "@256",
+    "D=A",
+    "@SP",
+    "M=D    // *SP = 256",
+    "@LCL",
+    "M=-1   // *LCL = -1, illegal value to start with",
+    "@ARG",
+    "M=-1   // *ARG = -1",
+    "@THIS",
+    "M=-1   // *THIS = -1",
+    "@THAT",
+    "M=-1   // *THAT = -1",
+  })
+    bootstrapCode.push_back(line);
+
+  CallInstruction sys_init_call("Sys.init", 0);
+  bootstrapCode.push_back(getComment(sys_init_call.toString()));
+  for (const std::string &line : sys_init_call.doTranslate())
+    bootstrapCode.push_back(line);
+
+  return bootstrapCode;
 }
@@ -1,25 +1,37 @@
 #ifndef __HACK__BUILDER__VM__H__
 #define __HACK__BUILDER__VM__H__
 
+#include <string_view>
 #include <vector>
 
 #include "generic/builder.h"
 #include "hack/utils.h"
 #include "./instruction.h"
 
-class HackBuilderVMTranslator: public Builder {
+class HackBuilderVMTranslator
+  : public InstructionBuilder<HackBuilderVMTranslator, VMInstructions> {
 public:
   HackBuilderVMTranslator();
   HackBuilderVMTranslator(const std::string&);
 
-  virtual Instruction* parseLine(const std::string &line);
-  virtual void visit(MemorySegment*);
-  virtual void visit(ArithmeticLogic*);
-  virtual void visit(BranchingInstruction*);
-  virtual void visit(FunctionInstruction*);
-  virtual void visit(ReturnInstruction*);
-  virtual void visit(CallInstruction*);
+  void parseLine(std::string_view line, VMInstructions &parsed);
+  void visit(MemorySegment*);
+  void visit(ArithmeticLogic*);
+  void visit(BranchingInstruction*);
+  void visit(FunctionInstruction*);
+  void visit(ReturnInstruction*);
+  void visit(CallInstruction*);
+  // sets up the registers and calls Sys.init, goes before a whole
+  // program.
+  static LineBuffer getBootstrapCode();
+protected:
+  // writes name of the file that generated the output in a comment
+  virtual void processLines(const LineIndex*) override;
 private:
+  template <class T>
+  void place(VMInstructions &parsed, std::string_view line) {
+    parsed.emplace<T>(line).setBuilder(this);
+  }
   void defaultVisit(VMTranslationInstruction*);
 
 private:
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -9,21 +10,36 @@
 #include "./builder.h"
 #include "./instruction.h"
 
-VMTranslationInstruction::VMTranslationInstruction(std::string line): Instruction(line), _builder(nullptr) {}
+VMTranslationInstruction::VMTranslationInstruction(std::string_view line): Instruction(line), _builder(nullptr) {}
 
 std::string VMTranslationInstruction::translate() {
   std::vector<std::string> lines = doTranslate();
   return join(lines, "\n");
 }
 
-void VMTranslationInstruction::accept(Builder *builder) {
-  if (!builder)
-    throw std::runtime_error("Something went wrong, no builder reference in accept of instruction: " + toString() + "\n");
-  _builder = builder;  // keep a reference of builder.
+void VMTranslationInstruction::setBuilder(Builder *builder) {
+  _builder = builder;
 }
 
 Builder* VMTranslationInstruction::getBuilder() { return _builder; }
 
+std::string VMTranslationInstruction::labelSuffix() {
+  if (!_builder)
+    return "";
+  return withNumber("." + fileScope() + ".", _builder->nextLabelId());
+}
+
+std::string VMTranslationInstruction::fileScope() {
+  std::string filename = _builder->getFilename();
+  if (!isStdio(filename))
+    return getStem(filename);
+  // code piped in has no file name; jack compiles each class into
+  // its own file, so the class of the crt function is the best guess.
+  std::string function = _builder->getCurrentFunction();
+  size_t dot = function.find('.');
+  return dot == std::string::npos ? "Stdin" : function.substr(0, dot);
+}
+
 // MemorySegment
 
 std::vector<std::string> MemorySegment::segments = {
@@ -31,7 +47,7 @@ std::vector<std::string> MemorySegment::segments = {
   "static", "constant", "pointer", "temp"
 };
 
-MemorySegment::MemorySegment(std::string line): VMTranslationInstruction(line) {
+MemorySegment::MemorySegment(std::string_view line): VMTranslationInstruction(line) {
   _parsed = false;
 }
 
@@ -66,19 +82,16 @@ bool MemorySegment::isValid() {
   return true;
 }
 
-void MemorySegment::accept(Builder *builder) {
-  VMTranslationInstruction::accept(builder);
-  dynamic_cast<HackBuilderVMTranslator*>(builder)->visit(this);
-}
-
-std::vector<std::string> MemorySegment::parse(const std::string &line) {
-  std::vector<std::string> parts;
+std::vector<std::string_view> MemorySegment::parse(std::string_view line) {
+  std::vector<std::string_view> parts;
   split(parts, line, " ");
-  trim(parts[0]);
-  trim(parts[1]);
-  trim(parts[2]);
+  if (parts.size() < 3)
+    throw std::runtime_error("Invalid command: " + std::string(line));
+  parts[0] = trim_view(parts[0]);
+  parts[1] = trim_view(parts[1]);
+  parts[2] = trim_view(parts[2]);
   if (!isNumber(parts[2]))
-    throw std::runtime_error("Invalid command: " + line);
+    throw std::runtime_error("Invalid command: " + std::string(line));
   return parts;
 }
 
@@ -86,10 +99,13 @@ void MemorySegment::parse() {
   if (_parsed)
     return;
 
-  std::vector<std::string> parts = MemorySegment::parse(toString());
+  std::vector<std::string_view> parts = MemorySegment::parse(view());
   _op = parts[0];
   _segment = parts[1];
-  _value = getNumber(parts[2]);
+  ParsedNumber value = parseNumber(parts[2]);
+  if (!value.ok())
+    throw std::runtime_error(std::string(numberErrorName(value.error)) + ": " + toString());
+  _value = value.value;
   _parsed = true;
 }
 
@@ -110,13 +126,13 @@ int MemorySegment::value() {
 
 // ConstantMemorySegment
 
-ConstantMemorySegment::ConstantMemorySegment(std::string s): MemorySegment(s) {}
+ConstantMemorySegment::ConstantMemorySegment(std::string_view s): MemorySegment(s) {}
 
 std::vector<std::string> ConstantMemorySegment::doTranslate() {
   std::vector<std::string> v;
   if (op() == "push")
     v = {
-      "@" + ::toString(value()),
+      withNumber("@", value()),
       "D=A      // save value in D",
       "@SP",
       "A=M",
@@ -138,7 +154,7 @@ std::unordered_map<std::string, std::string> SegmentBaseMemorySegment::segmentTo
   { "that", "THAT" },
 };
 
-SegmentBaseMemorySegment::SegmentBaseMemorySegment(std::string s): MemorySegment(s) {
+SegmentBaseMemorySegment::SegmentBaseMemorySegment(std::string_view s): MemorySegment(s) {
 }
 
 bool SegmentBaseMemorySegment::canHandleSegment(const std::string &seg) {
@@ -149,7 +165,7 @@ std::vector<std::string> SegmentBaseMemorySegment::doTranslate() {
   std::string baseName = segmentToBase.at(segment());
   if (op() == "pop")
     return {
-      "@" + ::toString(value()),
+      withNumber("@", value()),
       "D=A",
       "@" + baseName,
       "D=D+M    // D = (baseName + i), saves address offset",
@@ -166,7 +182,7 @@ std::vector<std::string> SegmentBaseMemorySegment::doTranslate() {
 
   if (op() == "push")
     return {
-      "@" + ::toString(value()),
+      withNumber("@", value()),
       "D=A",
       "@" + baseName,
       "A=D+M    // A = (baseName + i), go to that address",
@@ -183,7 +199,7 @@ std::vector<std::string> SegmentBaseMemorySegment::doTranslate() {
 
 // TempMemorySegment
 
-TempMemorySegment::TempMemorySegment(std::string l): MemorySegment(l) {}
+TempMemorySegment::TempMemorySegment(std::string_view l): MemorySegment(l) {}
 
 bool TempMemorySegment::isValid() {
   int val = value();
@@ -194,7 +210,7 @@ std::vector<std::string> TempMemorySegment::doTranslate() {
   int offset = BASE_SEGMENT + value();
   if (op() == "push")
     return {
-      "@" + ::toString(offset),
+      withNumber("@", offset),
       "D=M    // D = TEMP[base + i], get value from temp segment",
       "@SP",
       "A=M",
@@ -209,7 +225,7 @@ std::vector<std::string> TempMemorySegment::doTranslate() {
       "M=M-1  // SP--",
       "A=M",
       "D=M    // D = *SP",
-      "@" + ::toString(offset),
+      withNumber("@", offset),
       "M=D    // TEMP[base+i] = D, puts what's in stack in temp",
     };
 
@@ -218,7 +234,7 @@ std::vector<std::string> TempMemorySegment::doTranslate() {
 
 // PointerMemorySegment
 
-PointerMemorySegment::PointerMemorySegment(std::string l): MemorySegment(l) {}
+PointerMemorySegment::PointerMemorySegment(std::string_view l): MemorySegment(l) {}
 
 bool PointerMemorySegment::isValid() {
   int val = value();
@@ -253,15 +269,15 @@ std::vector<std::string> PointerMemorySegment::doTranslate() {
 
 // StaticMemorySegment
 
-StaticMemorySegment::StaticMemorySegment(std::string l): MemorySegment(l) { }
+StaticMemorySegment::StaticMemorySegment(std::string_view l): MemorySegment(l) { }
 
 std::vector<std::string> StaticMemorySegment::doTranslate() {
-  std::string filename = getStem(_builder->getFilename());
+  std::string filename = fileScope();
 
   // "push static 5" gets converted into "Filename.5",
   // which we'll treat as a variable by prepending @ to it.
   // (assuming instruction is in Filename.vm)
-  std::string varName = filename + "." + ::toString(value());
+  std::string varName = withNumber(filename + ".", value());
 
   if (op() == "push")
     return {
@@ -294,9 +310,9 @@ std::vector<std::string> ArithmeticLogic::ops = {
   "gt", "lt", "and", "or", "not",
 };
 
-ArithmeticLogic::ArithmeticLogic(std::string line): VMTranslationInstruction(line) {}
+ArithmeticLogic::ArithmeticLogic(std::string_view line): VMTranslationInstruction(line) {}
 
-bool ArithmeticLogic::isArithmeticLogicOp(const std::string &instr) {
+bool ArithmeticLogic::isArithmeticLogicOp(std::string_view instr) {
   auto it = std::find(ops.begin(), ops.end(), instr);
   return it != ops.end();
 }
@@ -305,18 +321,13 @@ bool ArithmeticLogic::isValid() {
   return isArithmeticLogicOp(value());
 }
 
-void ArithmeticLogic::accept(Builder *builder) {
-  VMTranslationInstruction::accept(builder);
-  dynamic_cast<HackBuilderVMTranslator*>(builder)->visit(this);
-}
-
 std::string ArithmeticLogic::value() {
-  return trim_copy(toString());
+  return std::string(trim_view(view()));
 }
 
 // AddArithmeticLogic
 
-AddArithmeticLogic::AddArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+AddArithmeticLogic::AddArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> AddArithmeticLogic::doTranslate() {
   return {
@@ -335,7 +346,7 @@ std::vector<std::string> AddArithmeticLogic::doTranslate() {
 
 // SubArithmeticLogic
 
-SubArithmeticLogic::SubArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+SubArithmeticLogic::SubArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> SubArithmeticLogic::doTranslate() {
   return {"@SP",
@@ -354,7 +365,7 @@ std::vector<std::string> SubArithmeticLogic::doTranslate() {
 
 // NegArithmeticLogic
 
-NegArithmeticLogic::NegArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+NegArithmeticLogic::NegArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> NegArithmeticLogic::doTranslate() {
   return {"@SP",
@@ -365,12 +376,10 @@ std::vector<std::string> NegArithmeticLogic::doTranslate() {
 
 // EqArithmeticLogic
 
-EqArithmeticLogic::EqArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+EqArithmeticLogic::EqArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> EqArithmeticLogic::doTranslate() {
-  static int i = 0;
-  i++;
-  std::string iStr = ::toString(i);
+  std::string iStr = labelSuffix();
   return {"@SP",
           "M=M-1     // SP--",
           "A=M",
@@ -397,12 +406,10 @@ std::vector<std::string> EqArithmeticLogic::doTranslate() {
 
 // GtArithmeticLogic
 
-GtArithmeticLogic::GtArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+GtArithmeticLogic::GtArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> GtArithmeticLogic::doTranslate() {
-  static int i = 0;
-  i++;
-  std::string iStr = ::toString(i);
+  std::string iStr = labelSuffix();
   return {"@SP",
           "M=M-1      // SP--",
           "A=M",
@@ -430,12 +437,10 @@ std::vector<std::string> GtArithmeticLogic::doTranslate() {
 
 // LtArithmeticLogic
 
-LtArithmeticLogic::LtArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+LtArithmeticLogic::LtArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> LtArithmeticLogic::doTranslate() {
-  static int i = 0;
-  i++;
-  std::string iStr = ::toString(i);
+  std::string iStr = labelSuffix();
   return {"@SP",
           "M=M-1      // SP--",
           "A=M",
@@ -463,7 +468,7 @@ std::vector<std::string> LtArithmeticLogic::doTranslate() {
 
 // AndArithmeticLogic
 
-AndArithmeticLogic::AndArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+AndArithmeticLogic::AndArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> AndArithmeticLogic::doTranslate() {
   return {"@SP",
@@ -481,7 +486,7 @@ std::vector<std::string> AndArithmeticLogic::doTranslate() {
 
 // OrArithmeticLogic
 
-OrArithmeticLogic::OrArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+OrArithmeticLogic::OrArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> OrArithmeticLogic::doTranslate() {
   return {"@SP",
@@ -499,7 +504,7 @@ std::vector<std::string> OrArithmeticLogic::doTranslate() {
 
 // NotArithmeticLogic
 
-NotArithmeticLogic::NotArithmeticLogic(std::string l): ArithmeticLogic(l) {}
+NotArithmeticLogic::NotArithmeticLogic(std::string_view l): ArithmeticLogic(l) {}
 
 std::vector<std::string> NotArithmeticLogic::doTranslate() {
   return {"@SP",
@@ -513,32 +518,30 @@ std::vector<std::string> NotArithmeticLogic::doTranslate() {
 
 // BranchingInstruction
 
-BranchingInstruction::BranchingInstruction(std::string str)
+BranchingInstruction::BranchingInstruction(std::string_view str)
   : VMTranslationInstruction(str) { }
 
-void BranchingInstruction::accept(Builder *builder) {
-  VMTranslationInstruction::accept(builder);
-  dynamic_cast<HackBuilderVMTranslator*>(builder)->visit(this);
-}
-
 std::string BranchingInstruction::label() {
-  std::vector<std::string> parts;
-  split(parts, toString(), " ");
-  return trim_copy(parts[1]);
+  std::vector<std::string_view> parts;
+  split(parts, view(), " ");
+  if (parts.size() < 2)
+    return "";
+  return std::string(trim_view(parts[1]));
 }
 
 std::string BranchingInstruction::cmd() {
-  std::vector<std::string> parts;
-  split(parts, toString(), " ");
-  return trim_copy(parts[0]);
+  std::vector<std::string_view> parts;
+  split(parts, view(), " ");
+  return std::string(trim_view(parts[0]));
 }
 
 // LabelInstruction
 
-LabelInstruction::LabelInstruction(std::string str)
+LabelInstruction::LabelInstruction(std::string_view str)
   : BranchingInstruction(str) {}
 
-LabelInstruction::LabelInstruction(BranchingInstruction &i): BranchingInstruction("label " + i.label()) {
+LabelInstruction::LabelInstruction(BranchingInstruction &i): BranchingInstruction("") {
+  set("label " + i.label());
   _builder = i.getBuilder();
 }
 
@@ -548,8 +551,7 @@ bool LabelInstruction::isValid() {
 
 std::string LabelInstruction::fullLabel() {
   std::string function = _builder->getCurrentFunction();
-  std::string filename = getStem(_builder->getFilename());
-  std::string prefix = function.empty() ? filename : function;
+  std::string prefix = function.empty() ? fileScope() : function;
   return prefix + "$" + label();
 }
 
@@ -561,7 +563,7 @@ std::vector<std::string> LabelInstruction::doTranslate() {
 
 // GotoInstruction
 
-GotoInstruction::GotoInstruction(std::string str)
+GotoInstruction::GotoInstruction(std::string_view str)
   : BranchingInstruction(str) {}
 
 bool GotoInstruction::isValid() {
@@ -578,7 +580,7 @@ std::vector<std::string> GotoInstruction::doTranslate() {
 
 // IfGotoInstruction
 
-IfGotoInstruction::IfGotoInstruction(std::string str)
+IfGotoInstruction::IfGotoInstruction(std::string_view str)
   : BranchingInstruction(str) {}
 
 bool IfGotoInstruction::isValid() {
@@ -601,23 +603,18 @@ std::vector<std::string> IfGotoInstruction::doTranslate() {
 
 // BaseFunctionsInstruction
 
-BaseFunctionsInstruction::BaseFunctionsInstruction(std::string str)
+BaseFunctionsInstruction::BaseFunctionsInstruction(std::string_view str)
   : VMTranslationInstruction(str) { }
 
 // FunctionInstruction
 
-FunctionInstruction::FunctionInstruction(std::string str)
+FunctionInstruction::FunctionInstruction(std::string_view str)
   : BaseFunctionsInstruction(str) { }
 
 bool FunctionInstruction::isValid() {
   return !name().empty() && nVars() >= 0;
 }
 
-void FunctionInstruction::accept(Builder *builder) {
-  VMTranslationInstruction::accept(builder);
-  dynamic_cast<HackBuilderVMTranslator*>(builder)->visit(this);
-}
-
 std::vector<std::string> FunctionInstruction::doTranslate() {
   std::vector<std::string> output {
     "(" + name() + ") // repeat nVar times: push 0",
@@ -640,31 +637,28 @@ std::vector<std::string> FunctionInstruction::doTranslate() {
 }
 
 std::string FunctionInstruction::name() {
-  std::vector<std::string> parts;
-  split(parts, toString(), " ");
-  return trim_copy(parts[1]);
+  std::vector<std::string_view> parts;
+  split(parts, view(), " ");
+  return std::string(trim_view(parts[1]));
 }
 
 int FunctionInstruction::nVars() {
-  std::vector<std::string> parts;
-  split(parts, toString(), " ");
-  return ::getNumber(trim_copy(parts[2]));
+  std::vector<std::string_view> parts;
+  split(parts, view(), " ");
+  // -1 makes isValid() fail on a bad count.
+  ParsedNumber n = parseNumber(trim_view(parts[2]));
+  return n.ok() ? n.value : -1;
 }
 
 // ReturnInstruction
 
-ReturnInstruction::ReturnInstruction(std::string line)
+ReturnInstruction::ReturnInstruction(std::string_view line)
   : BaseFunctionsInstruction(line) { }
 
 bool ReturnInstruction::isValid() {
   return true;
 }
 
-void ReturnInstruction::accept(Builder *builder) {
-  VMTranslationInstruction::accept(builder);
-  dynamic_cast<HackBuilderVMTranslator*>(builder)->visit(this);
-}
-
 std::vector<std::string> ReturnInstruction::doTranslate() {
   return {
     "@LCL",
@@ -721,27 +715,23 @@ std::vector<std::string> ReturnInstruction::doTranslate() {
 
 // CallInstruction
 
-CallInstruction::CallInstruction(std::string line)
+CallInstruction::CallInstruction(std::string_view line)
   : BaseFunctionsInstruction(line) {
   parse();
 }
 
 CallInstruction::CallInstruction(const std::string &funcName, int nArgs)
-  : BaseFunctionsInstruction(join(std::vector<std::string>{"call", funcName, ::toString(nArgs)}, " ")),
+  : BaseFunctionsInstruction(""),
     _funcName(funcName),
     _nArgs(nArgs)
 {
+  set(withNumber("call " + funcName + " ", nArgs));
 }
 
 bool CallInstruction::isValid() {
   return nArgs() >= 0 && !funcName().empty();
 }
 
-void CallInstruction::accept(Builder *builder) {
-  VMTranslationInstruction::accept(builder);
-  dynamic_cast<HackBuilderVMTranslator*>(builder)->visit(this);
-}
-
 std::string CallInstruction::funcName() { return _funcName; }
 
 int CallInstruction::nArgs() { return _nArgs; }
@@ -790,7 +780,7 @@ std::vector<std::string> CallInstruction::doTranslate() {
     "M=D      // LCL = SP, sets local of new running function",
     "@SP",
     "D=M",
-    "@" + ::toString(5 + _nArgs),
+    withNumber("@", 5 + _nArgs),
     "D=D-A",
     "@ARG",
     "M=D      // ARG = SP - 5 - nArgs, sets argument",
@@ -801,13 +791,13 @@ std::vector<std::string> CallInstruction::doTranslate() {
 }
 
 void CallInstruction::parse() {
-  std::vector<std::string> parts;
-  split(parts, toString(), " ");
-  _funcName = trim_copy(parts[1]);
-  _nArgs = ::getNumber(trim_copy(parts[2]));
+  std::vector<std::string_view> parts;
+  split(parts, view(), " ");
+  _funcName = trim_view(parts[1]);
+  ParsedNumber n = parseNumber(trim_view(parts[2]));
+  _nArgs = n.ok() ? n.value : -1;
 }
 
 std::string CallInstruction::getReturnAddress() {
-  static int i = -1;
-  return funcName() + "$ret." + ::toString(++i);
+  return funcName() + "$ret" + labelSuffix();
 }
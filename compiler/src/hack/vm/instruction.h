@@ -2,21 +2,32 @@
 #define __INSTRUCTION_VM__H__
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <variant>
 #include <vector>
 
 #include "generic/instruction.h"
 
+class Builder;
+
 // base
 
 class VMTranslationInstruction: public Instruction {
 public:
   std::string translate() override;
-  virtual void accept(Builder *builder) override;
+  // the builder translating this instruction, it numbers labels.
+  void setBuilder(Builder *builder);
   Builder *getBuilder();
   virtual std::vector<std::string> doTranslate() = 0;
 protected:
-  VMTranslationInstruction(std::string line);
+  VMTranslationInstruction(std::string_view line);
+  // ".<file>.<id>", makes generated labels unique within the
+  // whole program; empty if there's no builder to number them.
+  std::string labelSuffix();
+  // what statics and labels outside functions are prefixed with,
+  // normally the stem of the file being translated.
+  std::string fileScope();
 protected:
   Builder *_builder;
 };
@@ -25,12 +36,11 @@ protected:
 
 class MemorySegment: public VMTranslationInstruction {
 public:
-  static std::vector<std::string> parse(const std::string&);
+  static std::vector<std::string_view> parse(std::string_view);
   virtual bool isValid() override;
-  virtual void accept(Builder *builder) override;
 protected:
   // <op> <segment> <value>
-  MemorySegment(std::string);
+  MemorySegment(std::string_view);
   virtual void parse();
   virtual std::string segment();
   virtual std::string op();
@@ -43,24 +53,24 @@ protected:
   static std::vector<std::string> segments;
 };
 
-class ConstantMemorySegment : public MemorySegment {
+class ConstantMemorySegment final: public MemorySegment {
 public:
-  ConstantMemorySegment(std::string);
+  ConstantMemorySegment(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class SegmentBaseMemorySegment : public MemorySegment {
+class SegmentBaseMemorySegment final: public MemorySegment {
 public:
-  SegmentBaseMemorySegment(std::string);
+  SegmentBaseMemorySegment(std::string_view);
   static bool canHandleSegment(const std::string&);
   std::vector<std::string> doTranslate() override;
 private:
   static std::unordered_map<std::string, std::string> segmentToBase;
 };
 
-class TempMemorySegment : public MemorySegment {
+class TempMemorySegment final: public MemorySegment {
 public:
-  TempMemorySegment(std::string);
+  TempMemorySegment(std::string_view);
   virtual bool isValid() override;
   std::vector<std::string> doTranslate() override;
 private:
@@ -68,9 +78,9 @@ private:
   static constexpr int SIZE = 8;
 };
 
-class PointerMemorySegment: public MemorySegment {
+class PointerMemorySegment final: public MemorySegment {
 public:
-  PointerMemorySegment(std::string);
+  PointerMemorySegment(std::string_view);
   virtual bool isValid() override;
   std::vector<std::string> doTranslate() override;
 private:
@@ -78,9 +88,9 @@ private:
   static constexpr int SIZE = 2;
 };
 
-class StaticMemorySegment: public MemorySegment {
+class StaticMemorySegment final: public MemorySegment {
 public:
-  StaticMemorySegment(std::string);
+  StaticMemorySegment(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
@@ -88,67 +98,66 @@ public:
 
 class ArithmeticLogic: public VMTranslationInstruction {
 public:
-  static bool isArithmeticLogicOp(const std::string &);
+  static bool isArithmeticLogicOp(std::string_view);
   virtual bool isValid() override;
-  virtual void accept(Builder *builder) override;
 protected:
-  ArithmeticLogic(std::string);
+  ArithmeticLogic(std::string_view);
   std::string value();
 private:
   static std::vector<std::string> ops;
 };
 
-class AddArithmeticLogic: public ArithmeticLogic {
+class AddArithmeticLogic final: public ArithmeticLogic {
 public:
-  AddArithmeticLogic(std::string);
+  AddArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class SubArithmeticLogic: public ArithmeticLogic {
+class SubArithmeticLogic final: public ArithmeticLogic {
 public:
-  SubArithmeticLogic(std::string);
+  SubArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class NegArithmeticLogic: public ArithmeticLogic {
+class NegArithmeticLogic final: public ArithmeticLogic {
 public:
-  NegArithmeticLogic(std::string);
+  NegArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class EqArithmeticLogic: public ArithmeticLogic {
+class EqArithmeticLogic final: public ArithmeticLogic {
 public:
-  EqArithmeticLogic(std::string);
+  EqArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class GtArithmeticLogic: public ArithmeticLogic {
+class GtArithmeticLogic final: public ArithmeticLogic {
 public:
-  GtArithmeticLogic(std::string);
+  GtArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class LtArithmeticLogic: public ArithmeticLogic {
+class LtArithmeticLogic final: public ArithmeticLogic {
 public:
-  LtArithmeticLogic(std::string);
+  LtArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class AndArithmeticLogic: public ArithmeticLogic {
+class AndArithmeticLogic final: public ArithmeticLogic {
 public:
-  AndArithmeticLogic(std::string);
+  AndArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class OrArithmeticLogic: public ArithmeticLogic {
+class OrArithmeticLogic final: public ArithmeticLogic {
 public:
-  OrArithmeticLogic(std::string);
+  OrArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
-class NotArithmeticLogic: public ArithmeticLogic {
+class NotArithmeticLogic final: public ArithmeticLogic {
 public:
-  NotArithmeticLogic(std::string);
+  NotArithmeticLogic(std::string_view);
   std::vector<std::string> doTranslate() override;
 };
 
@@ -156,33 +165,32 @@ public:
 
 class BranchingInstruction: public VMTranslationInstruction {
 public:
-  virtual void accept(Builder *builder) override;
   // label|goto|if-goto <label>
   virtual std::string cmd();
   virtual std::string label();
 protected:
-  BranchingInstruction(std::string);
+  BranchingInstruction(std::string_view);
 };
 
-class LabelInstruction: public BranchingInstruction {
+class LabelInstruction final: public BranchingInstruction {
 public:
-  LabelInstruction(std::string);
+  LabelInstruction(std::string_view);
   LabelInstruction(BranchingInstruction&);  // copy constructor
   virtual bool isValid() override;
   std::string fullLabel();
   virtual std::vector<std::string> doTranslate() override;
 };
 
-class GotoInstruction: public BranchingInstruction {
+class GotoInstruction final: public BranchingInstruction {
 public:
-  GotoInstruction(std::string);
+  GotoInstruction(std::string_view);
   virtual bool isValid() override;
   virtual std::vector<std::string> doTranslate() override;
 };
 
-class IfGotoInstruction: public BranchingInstruction {
+class IfGotoInstruction final: public BranchingInstruction {
 public:
-  IfGotoInstruction(std::string);
+  IfGotoInstruction(std::string_view);
   virtual bool isValid() override;
   virtual std::vector<std::string> doTranslate() override;
 };
@@ -191,34 +199,31 @@ public:
 
 class BaseFunctionsInstruction: public VMTranslationInstruction {
 protected:
-  BaseFunctionsInstruction(std::string);
+  BaseFunctionsInstruction(std::string_view);
 };
 
-class FunctionInstruction: public BaseFunctionsInstruction {
+class FunctionInstruction final: public BaseFunctionsInstruction {
 public:
-  FunctionInstruction(std::string);
+  FunctionInstruction(std::string_view);
   std::string name();   // function name we're defining
   int nVars();          // number of local variables
 
   virtual bool isValid() override;
-  virtual void accept(Builder *builder) override;
   virtual std::vector<std::string> doTranslate() override;
 };
 
-class ReturnInstruction: public BaseFunctionsInstruction {
+class ReturnInstruction final: public BaseFunctionsInstruction {
 public:
-  ReturnInstruction(std::string);
+  ReturnInstruction(std::string_view);
   virtual bool isValid() override;
-  virtual void accept(Builder*) override;
   virtual std::vector<std::string> doTranslate() override;
 };
 
-class CallInstruction: public BaseFunctionsInstruction {
+class CallInstruction final: public BaseFunctionsInstruction {
 public:
-  CallInstruction(std::string line);
+  CallInstruction(std::string_view line);
   CallInstruction(const std::string &funcName, int nArgs);
   virtual bool isValid() override;
-  virtual void accept(Builder*) override;
   std::string funcName();
   int nArgs();
   virtual std::vector<std::string> doTranslate() override;
@@ -230,4 +235,15 @@ private:
   int _nArgs;
 };
 
+// every kind of line in a vm file, see InstructionBuilder.
+using VMInstructions = std::variant<
+  std::monostate,
+  ConstantMemorySegment, SegmentBaseMemorySegment, TempMemorySegment,
+  PointerMemorySegment, StaticMemorySegment,
+  AddArithmeticLogic, SubArithmeticLogic, NegArithmeticLogic,
+  EqArithmeticLogic, GtArithmeticLogic, LtArithmeticLogic,
+  AndArithmeticLogic, OrArithmeticLogic, NotArithmeticLogic,
+  LabelInstruction, GotoInstruction, IfGotoInstruction,
+  FunctionInstruction, ReturnInstruction, CallInstruction>;
+
 #endif
@@ -1,9 +1,12 @@
+#include <algorithm>
 #include <list>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "generic/source.h"
 #include "generic/utils.h"
+#include "hack/library.h"
 
 #include "./builder.h"
 #include "./instruction.h"
@@ -14,18 +17,15 @@ Translator* getTranslatorFromPath(const std::string &path) {
 }
 
 VMHackTranslator::VMHackTranslator(const std::string &path)
-  : HackTranslator(path) {
-  _builders.push_back(new HackBuilderVMTranslator(path));
-}
+  : HackTranslator(path) { }
 
-std::list<std::string>* VMHackTranslator::translateFile(const std::string &path) {
-  std::list<std::string> *out = Translator::translateFile(path);
-  // add a line at the beginning to know what file generated the output.
-  out->push_front(getComment("file: " + getFilename(path)));
-  return out;
+std::list<Builder*> VMHackTranslator::createBuilders() {
+  return { new HackBuilderVMTranslator(_path) };
 }
 
 std::string VMHackTranslator::getOutputFile() {
+  if (isStdio(_path))
+    return _path;
   PathType pathType = getPathType(_path);
   if (pathType == PathType::REG_FILE_TYPE) {
     return replaceExtension(_path, "asm");
@@ -40,44 +40,29 @@ std::string VMHackTranslator::getOutputFile() {
 
 std::string VMHackTranslator::extension() { return "vm"; }
 
-void VMHackTranslator::beforeWriteToFile(std::list<std::string> &lines) {
-  HackTranslator::beforeWriteToFile(lines);
+// each file translates on its own, only the bootstrap code is added
+// once they're all together.
+std::string VMHackTranslator::cacheStage() { return "vm-asm"; }
+
+LineBuffer VMHackTranslator::header() {
   // calls bootstrap code only if path is a directory. Convention
   // of the instructors, so individual files can be tested in isolation
   // w/o having to worry about the whole integration. But when we want
   // to compile a directory, then we need to bootstrap the code somehow
   // to call Sys.init.
-  if (getPathType(_path) == PathType::DIR_TYPE) {
-    std::list<std::string> code = getBootstrapCode();
-    lines.insert(lines.cbegin(), code.cbegin(), code.cend());
-  }
+  if (!isStdio(_path) && getPathType(_path) == PathType::DIR_TYPE)
+    return HackBuilderVMTranslator::getBootstrapCode();
+  return LineBuffer();
 }
 
-std::list<std::string> VMHackTranslator::getBootstrapCode() {
-  // first add registers initialization
-  std::list<std::string> bootstrapCode {
-    "// bootstrap code",
-    "@256",
-    "D=A",
-    "@SP",
-    "M=D    // *SP = 256",
-    "@LCL",
-    "M=-1   // *LCL = -1, illegal value to start with",
-    "@ARG",
-    "M=-1   // *ARG = -1",
-    "@THIS",
-    "M=-1   // *THIS = -1",
-    "@THAT",
-    "M=-1   // *THAT = -1",
-  };
-
-  CallInstruction sys_init_call("Sys.init", 0);
-  std::vector<std::string> tmp = sys_init_call.doTranslate();
-  bootstrapCode.push_back(getComment(sys_init_call.toString()));
-  bootstrapCode.insert(
-    bootstrapCode.cend(),
-    tmp.cbegin(), tmp.cend()
-  );
-
-  return bootstrapCode;
+void VMHackTranslator::makeLibrary(const std::vector<std::string> &inputFiles) {
+  createWorkers(std::max(1, std::min<int>(_jobs, inputFiles.size())));
+  writeLibrary(inputFiles, "asm", [&](int worker, const std::string &file,
+                                      LibraryClass &libraryClass) {
+    SourceBuffer source(file);
+    scanVMSymbols(source.lines(), libraryClass);
+    return translateSource(file, source, worker);
+  });
 }
+
+bool VMHackTranslator::linksVM() { return true; }
@@ -3,21 +3,24 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
+#include "generic/line_buffer.h"
 #include "hack/translator.h"
 
 class VMHackTranslator : public HackTranslator {
 public:
   VMHackTranslator(const std::string &path);
-  // writes name of the file that generated the output in a comment
-  std::list<std::string>* translateFile(const std::string &path) override;
 protected:
+  virtual std::list<Builder*> createBuilders() override;
   virtual std::string getOutputFile() override;
   virtual std::string extension() override;
-  // before writing to file, add bootstrap code
-  virtual void beforeWriteToFile(std::list<std::string>&) override;
-private:
-  std::list<std::string> getBootstrapCode();  // calls Sys.init
+  virtual std::string cacheStage() override;
+  // bootstrap code, for directories
+  virtual LineBuffer header() override;
+  // an asm library, each class translated on its own.
+  virtual void makeLibrary(const std::vector<std::string> &inputFiles) override;
+  virtual bool linksVM() override;
 };
 
 #endif
@@ -0,0 +1,102 @@
+#include <exception>
+#include <list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "generic/builder.h"
+#include "generic/line_buffer.h"
+#include "generic/source.h"
+#include "generic/translator.h"
+#include "generic/utils.h"
+#include "hack/asm/builder.h"
+#include "hack/jack/builder.h"
+#include "hack/vm/builder.h"
+
+#include "./libhcc.h"
+
+namespace hcc {
+
+// the tools' error messages end in a newline, diagnostics don't.
+static void fail(Result &result, const std::string &file, const std::exception &e) {
+  result.diagnostics.push_back({file, rstrip_copy(e.what(), "\n")});
+}
+
+// runBuilders over text in memory.
+static LineBuffer runOnText(const std::list<Builder*> &builders,
+                            std::string_view text, const std::string &name) {
+  LineIndex lines;
+  indexLines(lines, text);
+  return runBuilders(builders, lines, name);
+}
+
+static void assembleInto(Result &result, const std::string &name) {
+  // "-" keeps it from writing an .asm_debug file.
+  HackAssembler assembler("-");
+  try {
+    // like the tools' .hack, without empty lines.
+    result.hack = runOnText({&assembler}, result.asmCode, "-").text();
+  } catch (const std::exception &e) {
+    fail(result, name, e);
+  }
+}
+
+static void translateVMInto(Result &result, const std::vector<Source> &files,
+                            const Options &options) {
+  // one program, laid out the way VMTranslator writes a directory.
+  LineBuffer program;
+  if (options.bootstrap)
+    program = HackBuilderVMTranslator::getBootstrapCode();
+  HackBuilderVMTranslator builder;
+  for (const Source &file: files) {
+    try {
+      program.append(runOnText({&builder}, file.text, file.name));
+      program.push_back("");
+    } catch (const std::exception &e) {
+      fail(result, file.name, e);
+    }
+  }
+  if (!result.ok())
+    return;
+  result.asmCode = program.text();
+  if (options.target == Target::HACK)
+    assembleInto(result, "");
+}
+
+Result compileJack(const std::vector<Source> &classes, const Options &options) {
+  Result result;
+  JackCompilationEngineBuilder builder;
+  for (const Source &jackClass: classes) {
+    try {
+      LineIndex lines;
+      indexLines(lines, jackClass.text);
+      LineBuffer vmCode = builder.compile(lines);
+      result.vm.push_back({replaceExtension(jackClass.name, "vm"),
+                           std::string(vmCode.text())});
+    } catch (const std::exception &e) {
+      fail(result, jackClass.name, e);
+    }
+  }
+  if (result.ok() && options.target != Target::VM)
+    translateVMInto(result, result.vm, options);
+  return result;
+}
+
+Result translateVM(const std::vector<Source> &files, const Options &options) {
+  Result result;
+  // already there.
+  if (options.target == Target::VM)
+    result.vm = files;
+  else
+    translateVMInto(result, files, options);
+  return result;
+}
+
+Result assemble(const Source &program) {
+  Result result;
+  result.asmCode = program.text;
+  assembleInto(result, program.name);
+  return result;
+}
+
+}  // namespace hcc
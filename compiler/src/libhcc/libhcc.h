@@ -0,0 +1,64 @@
+#ifndef __LIBHCC__H__
+#define __LIBHCC__H__
+
+#include <string>
+#include <vector>
+
+// The tools as plain functions: sources go in as text, outputs and
+// diagnostics come back as text. Nothing is read from or written to
+// disk and no state is shared between calls, so any number of them
+// can run at once, on any threads.
+namespace hcc {
+
+struct Source {
+  // e.g. "Main.jack"; statics and labels are named after it, but it's
+  // never opened.
+  std::string name;
+  std::string text;
+};
+
+struct Diagnostic {
+  std::string file;  // a Source name, empty for the whole program
+  std::string message;
+};
+
+// how far compileJack and translateVM go.
+enum class Target {
+  VM,
+  ASM,
+  HACK,
+};
+
+struct Options {
+  Target target = Target::HACK;
+  // start with the code calling Sys.init, like the tools do for a
+  // directory; off for a lone file, e.g. a test with no OS.
+  bool bootstrap = true;
+};
+
+// Every stage reached is filled in, the same text the tools would
+// write to their output files.
+struct Result {
+  bool ok() const { return diagnostics.empty(); }
+
+  std::vector<Source> vm;  // one per jack class, named Class.vm
+  std::string asmCode;     // the whole program
+  std::string hack;
+  // the first error of every input that had one; stages after
+  // failing ones don't run.
+  std::vector<Diagnostic> diagnostics;
+};
+
+// jack classes, in the order a directory would list them (sorted).
+Result compileJack(const std::vector<Source> &classes,
+                   const Options &options = Options());
+// vm files into one asm program, then hack if asked for; for
+// Target::VM, the files come back in vm as they are.
+Result translateVM(const std::vector<Source> &files,
+                   const Options &options = Options());
+// a single asm program.
+Result assemble(const Source &program);
+
+}  // namespace hcc
+
+#endif
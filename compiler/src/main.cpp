@@ -1,33 +1,190 @@
+#include <algorithm>
 #include <cstdlib>
+#include <exception>
 #include <vector>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 
+#include "generic/batch.h"
+#include "generic/cache.h"
+#include "generic/parallel.h"
+#include "generic/source.h"
+#include "generic/stats.h"
+#include "generic/trace.h"
 #include "generic/utils.h"
 #include "generic/translator.h"
 
 extern Translator* getTranslatorFromPath(const std::string &path);
 
 void usage(char *exec) {
-  std::cout << "Usage:\n" << exec << " <path|file>\n";
+  status() << "Usage:\n" << exec
+            << " [-j N] [-o FILE] [--cache=DIR] [--save-temps] [--pipeline]\n"
+            << "  [--stats] [--trace=FILE] [--manifest=FILE] [--watch] [--lib=FILE]...\n"
+            << "  [--make-lib=FILE] [--format=text|bin|hex|rom] <path|file|->...\n"
+            << "  -j N          translate N files at once (0 = one per core); asm/hcc\n"
+            << "                also assemble a long program on N threads\n"
+            << "  -o FILE       write the output to FILE, - for stdout\n"
+            << "  --cache=DIR   keep translations of single files in DIR and reuse\n"
+            << "                them while the files don't change\n"
+            << "  --save-temps  hcc: also write the .vm and .asm files in between\n"
+            << "  --pipeline    vm: read, translate and write files at the\n"
+            << "                same time, keeping only a few in memory (text\n"
+            << "                output only)\n"
+            << "  --stats       print time spent in each phase and some counts, and\n"
+            << "                allocations in builds with -DHCC_ALLOC_STATS=ON\n"
+            << "  --trace=FILE  write a timeline of files, passes and jack\n"
+            << "                subroutines to FILE as chrome trace events\n"
+            << "  --manifest=FILE  also translate the paths listed in FILE, one\n"
+            << "                per line; # starts a comment\n"
+            << "  --watch       build, then build again whenever an input file\n"
+            << "                changes, reusing what didn't; runs until killed\n"
+            << "  --lib=FILE    vm/asm/hcc: link the classes the program calls from\n"
+            << "                the library in FILE, instead of translating them\n"
+            << "  --make-lib=FILE  jack/vm: bundle the translated classes into a\n"
+            << "                library in FILE, with an index of their functions\n"
+            << "  --format=F    asm/hcc: write the hack code as text (the default),\n"
+            << "                bin (packed big-endian 16-bit words), hex (Intel\n"
+            << "                HEX) or rom (bin after an HROM header); the output\n"
+            << "                file gets .hack, .bin, .hex or .rom\n"
+            << "  a path of - reads stdin and writes to stdout\n"
+            << "  several paths are translated as independent projects, N at once\n";
+}
+
+struct Options {
+  std::string outputFile;
+  int jobs = 1;
+  bool saveTemps = false;
+  bool pipeline = false;
+  bool watch = false;
+  std::vector<std::string> libraries;
+  std::string makeLibrary;
+  std::string format = "text";
+  BuildCache *cache = nullptr;
+};
+
+// translates a single project.
+static void translatePath(const std::string &path, const Options &options) {
+  std::unique_ptr<Translator> translator(getTranslatorFromPath(path));
+  translator->setJobs(options.jobs);
+  translator->setOutputFile(options.outputFile);
+  translator->setSaveTemps(options.saveTemps);
+  translator->setPipeline(options.pipeline);
+  translator->setCache(options.cache);
+  for (const std::string &library: options.libraries)
+    translator->addLibrary(library);
+  translator->setMakeLibrary(options.makeLibrary);
+  translator->setFormat(options.format);
+  if (options.watch)
+    translator->watch();
+  else
+    translator->translate();
 }
 
 int main(int argc, char **argv) {
-  if (argc != 2) {
+  std::vector<std::string> paths;
+  std::string cacheDir;
+  Options options;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg(argv[i]);
+      if (startsWith(arg, "-j")) {
+        std::string n = arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : "");
+        ParsedNumber parsed = parseNumber(n);
+        if (!parsed.ok()) {
+          usage(argv[0]);
+          std::exit(1);
+        }
+        options.jobs = parsed.value;
+        if (options.jobs <= 0)
+          options.jobs = hardwareJobs();
+      } else if (arg == "--save-temps") {
+        options.saveTemps = true;
+      } else if (arg == "--pipeline") {
+        options.pipeline = true;
+      } else if (startsWith(arg, "--lib=") && arg.size() > 6) {
+        options.libraries.push_back(arg.substr(6));
+      } else if (startsWith(arg, "--make-lib=") && arg.size() > 11) {
+        options.makeLibrary = arg.substr(11);
+      } else if (startsWith(arg, "--format=") && arg.size() > 9) {
+        options.format = arg.substr(9);
+      } else if (arg == "--watch") {
+        options.watch = true;
+      } else if (startsWith(arg, "--cache=") && arg.size() > 8) {
+        cacheDir = arg.substr(8);
+      } else if (arg == "--stats") {
+        Stats::enable();
+      } else if (startsWith(arg, "--trace=") && arg.size() > 8) {
+        Trace::enable(arg.substr(8));
+      } else if (startsWith(arg, "--manifest=") && arg.size() > 11) {
+        readManifest(paths, arg.substr(11));
+      } else if (arg == "-o" && i + 1 < argc) {
+        options.outputFile = argv[++i];
+      } else if (arg.size() > 1 && arg.front() == '-') {
+        usage(argv[0]);
+        std::exit(1);
+      } else {
+        paths.push_back(arg);
+      }
+    }
+  } catch (std::exception &e) {
+    status() << e.what();
+    return 1;
+  }
+  // one output file or stdin can't be shared by several projects.
+  bool batch = paths.size() > 1;
+  bool anyStdio = std::find_if(paths.begin(), paths.end(), isStdio) != paths.end();
+  if (paths.empty() ||
+      (batch && (!options.outputFile.empty() || !options.makeLibrary.empty() || anyStdio)) ||
+      (options.watch && (batch || anyStdio))) {
     usage(argv[0]);
     std::exit(1);
   }
 
-  std::string path(argv[1]);
-  Translator *translator = getTranslatorFromPath(path);
+  // keep stdout clean for the output itself.
+  if (isStdio(options.outputFile) || (options.outputFile.empty() && isStdio(paths[0])))
+    statusToStderr();
+
+  int exitCode = 0;
+  std::unique_ptr<BuildCache> cache;
   try {
-    translator->translate();
-  } catch (std::runtime_error &e) {
-    std::cout << e.what();
+    if (!cacheDir.empty()) {
+      cache.reset(new BuildCache(cacheDir));
+      options.cache = cache.get();
+    }
+    // rebuilds take what didn't change from memory.
+    if (options.watch) {
+      if (!cache)
+        cache.reset(new BuildCache());
+      cache->setResident(true);
+      options.cache = cache.get();
+    }
+    if (batch) {
+      // each project on a single thread, jobs of them at once.
+      Options projectOptions = options;
+      projectOptions.jobs = 1;
+      exitCode = translateBatch(paths, options.jobs, [&](const std::string &path) {
+        translatePath(path, projectOptions);
+      });
+    } else {
+      translatePath(paths[0], options);
+    }
+    Stats::report(status());
+  } catch (std::exception &e) {
+    status() << e.what();
     usage(argv[0]);
+    exitCode = 1;
+  }
+
+  try {
+    // also when translation failed, to see how far it got.
+    Trace::write();
+  } catch (std::exception &e) {
+    status() << e.what();
+    exitCode = 1;
   }
 
-  delete translator;
-  return 0;
+  return exitCode;
 }
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/batch.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// a manifest in a dir next to the test binary, removed after.
+struct fixture {
+  const string dir = "test_batch_dir";
+
+  fixture() {
+    fs::remove_all(dir);
+    fs::create_directory(dir);
+  }
+  ~fixture() { fs::remove_all(dir); }
+
+  string manifest(const string &text) {
+    string path = dir + "/projects.txt";
+    ofstream out(path, ios::binary | ios::trunc);
+    out << text;
+    return path;
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_manifest_comments_and_blank_lines, fixture) {
+  vector<string> paths = {"first"};
+  readManifest(paths, manifest(
+    "# projects to build\n"
+    "\n"
+    "Pong\n"
+    "  Square   # with a comment after\n"
+    "   \n"
+    "\t# indented comment\n"
+    "/abs/Chess\n"
+    "Last"));
+  vector<string> expected = {
+    "first",  // what was there stays
+    dir + "/Pong",
+    dir + "/Square",
+    "/abs/Chess",
+    dir + "/Last",  // no newline at the end
+  };
+  BOOST_CHECK_EQUAL_COLLECTIONS(paths.begin(), paths.end(),
+                                expected.begin(), expected.end());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_manifest_missing, fixture) {
+  vector<string> paths;
+  BOOST_CHECK_THROW(readManifest(paths, dir + "/none.txt"), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_all_ok) {
+  vector<string> done;
+  mutex m;
+  int code = translateBatch({"a", "b", "c"}, 2, [&](const string &path) {
+    lock_guard<mutex> lock(m);
+    done.push_back(path);
+  });
+  BOOST_CHECK_EQUAL(code, 0);
+  BOOST_CHECK_EQUAL(done.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_failures_dont_stop_others) {
+  // whatever a project throws, the rest still get translated.
+  for (int jobs: {1, 4}) {
+    vector<string> paths = {"ok1", "runtime", "logic", "range", "alloc", "ok2"};
+    vector<int> translated(paths.size());
+    int code = translateBatch(paths, jobs, [&](const string &path) {
+      ++translated[find(paths.begin(), paths.end(), path) - paths.begin()];
+      if (path == "runtime")
+        throw runtime_error("Error parsing line: 3\n");
+      if (path == "logic")
+        throw logic_error("logic");
+      if (path == "range")
+        vector<int>().at(1);
+      if (path == "alloc")
+        throw bad_alloc();
+    });
+    BOOST_CHECK_EQUAL(code, 1);
+    for (int n: translated)
+      BOOST_CHECK_EQUAL(n, 1);
+  }
+}
@@ -0,0 +1,175 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/cache.h"
+#include "generic/line_buffer.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// a cache dir next to the test binary, removed after; translate()
+// counts how often the cache had to call it.
+struct fixture {
+  const string dir = "test_cache_dir";
+  int translations = 0;
+
+  fixture() { fs::remove_all(dir); }
+  ~fixture() { fs::remove_all(dir); }
+
+  string get(BuildCache &cache, string_view input, const string &salt,
+             const string &output) {
+    LineBuffer lines = cache.get(input, salt, [&] {
+      ++translations;
+      LineBuffer result;
+      result.appendText(output);
+      return result;
+    });
+    return string(lines.text());
+  }
+
+  // the only entry in the dir, after a single store.
+  fs::path entry() {
+    vector<fs::path> files;
+    for (const fs::directory_entry &e: fs::recursive_directory_iterator(dir))
+      if (e.is_regular_file())
+        files.push_back(e.path());
+    BOOST_REQUIRE_EQUAL(files.size(), 1);
+    return files[0];
+  }
+
+  void overwrite(const fs::path &path, const string &text) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out << text;
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_miss_then_hit, fixture) {
+  BuildCache cache(dir);
+  string salt = BuildCache::salt("jack-vm", "Main.jack", "");
+  BOOST_CHECK_EQUAL(get(cache, "class Main {}", salt, "a\nb\n"), "a\nb\n");
+  BOOST_CHECK_EQUAL(translations, 1);
+  BOOST_CHECK_EQUAL(get(cache, "class Main {}", salt, "other\n"), "a\nb\n");
+  BOOST_CHECK_EQUAL(translations, 1);
+  // changed input, another entry.
+  BOOST_CHECK_EQUAL(get(cache, "class Main { }", salt, "c\n"), "c\n");
+  BOOST_CHECK_EQUAL(translations, 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_hit_across_instances, fixture) {
+  string salt = BuildCache::salt("vm-asm", "Main.vm", "");
+  {
+    BuildCache cache(dir);
+    get(cache, "add", salt, "@SP\n");
+  }
+  // a later run reads what an earlier one stored.
+  BuildCache cache(dir);
+  BOOST_CHECK_EQUAL(get(cache, "add", salt, "other\n"), "@SP\n");
+  BOOST_CHECK_EQUAL(translations, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_empty_output, fixture) {
+  BuildCache cache(dir);
+  string salt = BuildCache::salt("vm-asm", "Empty.vm", "");
+  BOOST_CHECK_EQUAL(get(cache, "", salt, ""), "");
+  BOOST_CHECK_EQUAL(get(cache, "", salt, "other\n"), "");
+  BOOST_CHECK_EQUAL(translations, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_no_collision, fixture) {
+  BuildCache cache(dir);
+  string input = "function Main.main 0";
+  BOOST_CHECK_EQUAL(get(cache, input, BuildCache::salt("jack-vm", "Main.jack", ""), "1\n"), "1\n");
+  // same input, another stage or file name.
+  BOOST_CHECK_EQUAL(get(cache, input, BuildCache::salt("vm-asm", "Main.jack", ""), "2\n"), "2\n");
+  BOOST_CHECK_EQUAL(get(cache, input, BuildCache::salt("jack-vm", "Other.jack", ""), "3\n"), "3\n");
+  BOOST_CHECK_EQUAL(translations, 3);
+  // only the file name counts, not the dir it's in.
+  BOOST_CHECK_EQUAL(get(cache, input, BuildCache::salt("jack-vm", "src/Main.jack", ""), "4\n"), "1\n");
+  BOOST_CHECK_EQUAL(translations, 3);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_options_miss, fixture) {
+  BuildCache cache(dir);
+  string input = "add";
+  string text = BuildCache::salt("vm-asm", "Main.vm", "format=hack");
+  string bin = BuildCache::salt("vm-asm", "Main.vm", "format=bin");
+  BOOST_CHECK_EQUAL(get(cache, input, text, "1\n"), "1\n");
+  // output made with other options isn't reused.
+  BOOST_CHECK_EQUAL(get(cache, input, bin, "2\n"), "2\n");
+  BOOST_CHECK_EQUAL(get(cache, input, BuildCache::salt("vm-asm", "Main.vm", ""), "3\n"), "3\n");
+  BOOST_CHECK_EQUAL(translations, 3);
+  BOOST_CHECK_EQUAL(get(cache, input, text, "4\n"), "1\n");
+  BOOST_CHECK_EQUAL(get(cache, input, bin, "4\n"), "2\n");
+  BOOST_CHECK_EQUAL(translations, 3);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_resident_memory_only, fixture) {
+  BuildCache cache;
+  string salt = BuildCache::salt("jack-vm", "Main.jack", "");
+  BOOST_CHECK_EQUAL(get(cache, "v1", salt, "one\n"), "one\n");
+  BOOST_CHECK_EQUAL(get(cache, "v1", salt, "other\n"), "one\n");
+  BOOST_CHECK_EQUAL(translations, 1);
+  // a file that changed replaces its entry, so going back translates.
+  BOOST_CHECK_EQUAL(get(cache, "v2", salt, "two\n"), "two\n");
+  BOOST_CHECK_EQUAL(get(cache, "v1", salt, "one again\n"), "one again\n");
+  BOOST_CHECK_EQUAL(translations, 3);
+  BOOST_CHECK(!fs::exists(dir));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_resident_over_dir, fixture) {
+  BuildCache cache(dir);
+  cache.setResident(true);
+  string salt = BuildCache::salt("jack-vm", "Main.jack", "");
+  get(cache, "v1", salt, "one\n");
+  // served from memory, even with the disk entry gone.
+  fs::remove_all(dir);
+  BOOST_CHECK_EQUAL(get(cache, "v1", salt, "other\n"), "one\n");
+  BOOST_CHECK_EQUAL(translations, 1);
+
+  cache.setResident(false);
+  fs::create_directory(dir);
+  BOOST_CHECK_EQUAL(get(cache, "v1", salt, "from disk\n"), "from disk\n");
+  BOOST_CHECK_EQUAL(translations, 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_damaged_entry_is_a_miss, fixture) {
+  string salt = BuildCache::salt("vm-asm", "Main.vm", "");
+  string output = "@256\nD=A\n@SP\nM=D\n";
+  vector<string> damaged = {
+    "",
+    "@256\nD=A\n",               // cut at a line end
+    "@256\nD=A\n@SP\nM=D\n",     // no trailer
+    "@256\nD=A\n@SP\nM=D\n#hcc", // cut inside the trailer
+  };
+  {
+    BuildCache cache(dir);
+    get(cache, "push constant 256", salt, output);
+  }
+  fs::path path = entry();
+  string stored;
+  {
+    ifstream in(path, ios::binary);
+    stored.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+  }
+  string flipped = stored;
+  flipped[1] = '3';
+  damaged.push_back(flipped);
+
+  for (const string &text: damaged) {
+    overwrite(path, text);
+    BuildCache cache(dir);
+    int before = translations;
+    BOOST_CHECK_EQUAL(get(cache, "push constant 256", salt, output), output);
+    BOOST_CHECK_MESSAGE(translations == before + 1, "\"" << text << "\" was a hit");
+    // and the miss wrote a good entry back.
+    ifstream in(path, ios::binary);
+    string rewritten(istreambuf_iterator<char>(in), (istreambuf_iterator<char>()));
+    BOOST_CHECK_EQUAL(rewritten, stored);
+  }
+}
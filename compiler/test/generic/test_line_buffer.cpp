@@ -0,0 +1,137 @@
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/line_buffer.h"
+
+using namespace std;
+
+static vector<string> lines(const LineBuffer &buffer) {
+  vector<string> out;
+  for (size_t i = 0; i < buffer.size(); ++i)
+    out.push_back(string(buffer[i]));
+  return out;
+}
+
+static LineBuffer bufferOf(const vector<string> &lines) {
+  LineBuffer buffer;
+  for (const string &line: lines)
+    buffer.push_back(line);
+  return buffer;
+}
+
+BOOST_AUTO_TEST_CASE(test_push_back) {
+  LineBuffer buffer;
+  buffer.push_back("@2");
+  buffer.push_back("");
+  buffer.push_back("D=A\n0;JMP");
+  vector<string> expected = {"@2", "", "D=A", "0;JMP"};
+  BOOST_CHECK(lines(buffer) == expected);
+  BOOST_CHECK_EQUAL(buffer.text(), "@2\n\nD=A\n0;JMP\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_empty) {
+  LineBuffer buffer;
+  BOOST_CHECK(buffer.empty());
+  BOOST_CHECK(buffer.text().empty());
+  BOOST_CHECK(buffer.index().empty());
+  buffer.appendText("");
+  BOOST_CHECK(buffer.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_append_text) {
+  LineBuffer buffer = bufferOf({"first"});
+  buffer.appendText("a\n\nb\n");
+  // a last line without '\n' gets one.
+  buffer.appendText("c");
+  vector<string> expected = {"first", "a", "", "b", "c"};
+  BOOST_CHECK(lines(buffer) == expected);
+  BOOST_CHECK_EQUAL(buffer.text(), "first\na\n\nb\nc\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_append_and_prepend) {
+  LineBuffer buffer = bufferOf({"b", "c"});
+  buffer.append(bufferOf({"d"}));
+  buffer.prepend(bufferOf({"", "a"}));
+  vector<string> expected = {"", "a", "b", "c", "d"};
+  BOOST_CHECK(lines(buffer) == expected);
+  BOOST_CHECK_EQUAL(buffer.text(), "\na\nb\nc\nd\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_append_fixed) {
+  LineBuffer buffer = bufferOf({"first"});
+  char *text = buffer.appendFixed(3, 4);
+  memcpy(text, "0000", 4);
+  memcpy(text + 5, "1111", 4);
+  memcpy(text + 10, "2222", 4);
+  buffer.push_back("last");
+  vector<string> expected = {"first", "0000", "1111", "2222", "last"};
+  BOOST_CHECK(lines(buffer) == expected);
+  BOOST_CHECK_EQUAL(buffer.text(), "first\n0000\n1111\n2222\nlast\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_grows_in_order) {
+  // well past any initial capacity, mixing every way to add lines.
+  LineBuffer buffer;
+  vector<string> expected;
+  for (int i = 0; i < 5000; ++i) {
+    string line = "line " + to_string(i);
+    switch (i % 3) {
+    case 0:
+      buffer.push_back(line);
+      break;
+    case 1:
+      buffer.appendText(line + "\n");
+      break;
+    case 2:
+      memcpy(buffer.appendFixed(1, line.size()), line.data(), line.size());
+      break;
+    }
+    expected.push_back(line);
+  }
+  buffer.prepend(bufferOf({"head"}));
+  expected.insert(expected.begin(), "head");
+  BOOST_CHECK(lines(buffer) == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_index_after_growing) {
+  LineBuffer buffer = bufferOf({"a", "b"});
+  for (int i = 0; i < 5000; ++i)
+    buffer.push_back("more");
+  // an index taken now views the grown text, not the old one.
+  LineIndex index = buffer.index();
+  BOOST_CHECK_EQUAL(index.size(), 5002);
+  BOOST_CHECK_EQUAL(index[0], "a");
+  BOOST_CHECK_EQUAL(index[5001], "more");
+  BOOST_CHECK(index[0].data() == buffer.text().data());
+  BOOST_CHECK(index.back().data() + 5 == buffer.text().data() + buffer.text().size());
+}
+
+BOOST_AUTO_TEST_CASE(test_move) {
+  // builders hand their output over by move, leaving theirs empty.
+  LineBuffer buffer = bufferOf({"@2", "D=A"});
+  LineBuffer moved(std::move(buffer));
+  BOOST_CHECK(buffer.empty());
+  BOOST_CHECK(buffer.text().empty());
+  vector<string> expected = {"@2", "D=A"};
+  BOOST_CHECK(lines(moved) == expected);
+
+  LineBuffer assigned = bufferOf({"old"});
+  assigned = std::move(moved);
+  BOOST_CHECK(moved.empty());
+  BOOST_CHECK(lines(assigned) == expected);
+  BOOST_CHECK_EQUAL(assigned.text(), "@2\nD=A\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_clear) {
+  LineBuffer buffer = bufferOf({"a", "b"});
+  buffer.clear();
+  BOOST_CHECK(buffer.empty());
+  buffer.push_back("c");
+  vector<string> expected = {"c"};
+  BOOST_CHECK(lines(buffer) == expected);
+}
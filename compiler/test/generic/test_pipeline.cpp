@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/pipeline.h"
+#include "generic/queue.h"
+
+using namespace std;
+namespace utf = boost::unit_test;
+
+// BoundedQueue
+
+BOOST_AUTO_TEST_CASE(test_queue_fifo) {
+  BoundedQueue<int> queue(3);
+  BOOST_CHECK(queue.push(1));
+  BOOST_CHECK(queue.push(2));
+  BOOST_CHECK(queue.push(3));
+  int item = 0;
+  BOOST_CHECK(queue.pop(item));
+  BOOST_CHECK_EQUAL(item, 1);
+  BOOST_CHECK(queue.push(4));
+  for (int expected: {2, 3, 4}) {
+    BOOST_CHECK(queue.pop(item));
+    BOOST_CHECK_EQUAL(item, expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_queue_close_drains, *utf::timeout(10)) {
+  BoundedQueue<int> queue(2);
+  queue.push(1);
+  queue.close();
+  BOOST_CHECK(!queue.push(2));
+  int item = 0;
+  BOOST_CHECK(queue.pop(item));
+  BOOST_CHECK_EQUAL(item, 1);
+  BOOST_CHECK(!queue.pop(item));
+}
+
+BOOST_AUTO_TEST_CASE(test_queue_cancel_drops, *utf::timeout(10)) {
+  BoundedQueue<int> queue(2);
+  queue.push(1);
+  queue.cancel();
+  int item = 0;
+  BOOST_CHECK(!queue.pop(item));
+  BOOST_CHECK(!queue.push(2));
+}
+
+BOOST_AUTO_TEST_CASE(test_queue_push_waits_while_full, *utf::timeout(10)) {
+  BoundedQueue<int> queue(1);
+  queue.push(1);
+  atomic<bool> pushed(false);
+  thread producer([&] {
+    queue.push(2);
+    pushed = true;
+  });
+  this_thread::sleep_for(chrono::milliseconds(20));
+  BOOST_CHECK(!pushed);
+  int item = 0;
+  queue.pop(item);
+  producer.join();
+  BOOST_CHECK(pushed);
+  BOOST_CHECK(queue.pop(item));
+  BOOST_CHECK_EQUAL(item, 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_queue_close_wakes_pop, *utf::timeout(10)) {
+  BoundedQueue<int> queue(1);
+  thread consumer([&] {
+    int item = 0;
+    BOOST_CHECK(!queue.pop(item));
+  });
+  this_thread::sleep_for(chrono::milliseconds(20));
+  queue.close();
+  consumer.join();
+}
+
+// pipeline
+
+// runs count items through the pipeline; later items translate
+// faster, so workers finish them out of order.
+static vector<string> runPipeline(size_t count, int jobs, size_t window) {
+  vector<string> written;
+  atomic<size_t> writes(0);
+  atomic<bool> tooFarAhead(false);
+  size_t ahead = max<size_t>(window, 1);
+  pipeline<int, string>(
+    count, jobs, window,
+    [&](size_t i) {
+      if (i >= writes + ahead)
+        tooFarAhead = true;
+      return static_cast<int>(i);
+    },
+    [&](int, size_t i, int &item) {
+      this_thread::sleep_for(chrono::microseconds((count - i) % 7 * 200));
+      return "item " + to_string(item);
+    },
+    [&](size_t i, string &result) {
+      BOOST_CHECK_EQUAL(i, written.size());
+      written.push_back(result);
+      ++writes;
+    });
+  BOOST_CHECK_MESSAGE(!tooFarAhead, "read more than " << ahead << " items ahead");
+  return written;
+}
+
+static vector<string> items(size_t count) {
+  vector<string> out;
+  for (size_t i = 0; i < count; ++i)
+    out.push_back("item " + to_string(i));
+  return out;
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_in_order, *utf::timeout(30)) {
+  BOOST_CHECK(runPipeline(40, 4, 8) == items(40));
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_counts_around_window, *utf::timeout(30)) {
+  for (size_t count: {0, 1, 3, 7, 8, 9, 50}) {
+    BOOST_TEST_CONTEXT("count " << count) {
+      BOOST_CHECK(runPipeline(count, 3, 8) == items(count));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_single_job_and_window, *utf::timeout(30)) {
+  BOOST_CHECK(runPipeline(20, 1, 1) == items(20));
+  // both get raised to 1.
+  BOOST_CHECK(runPipeline(20, 0, 0) == items(20));
+  BOOST_CHECK(runPipeline(5, 8, 2) == items(5));
+}
+
+enum class Stage { READ, TRANSLATE, WRITE };
+
+// throws from stage on item failAt; the error must get out, and
+// nothing at or after failAt gets written.
+static void checkFails(Stage stage, size_t count, size_t failAt) {
+  size_t written = 0;
+  try {
+    pipeline<int, int>(
+      count, 4, 4,
+      [&](size_t i) {
+        if (stage == Stage::READ && i == failAt)
+          throw runtime_error("read " + to_string(i));
+        return static_cast<int>(i);
+      },
+      [&](int, size_t i, int &item) {
+        if (stage == Stage::TRANSLATE && i == failAt)
+          throw runtime_error("translate " + to_string(i));
+        return item;
+      },
+      [&](size_t i, int &) {
+        if (stage == Stage::WRITE && i == failAt)
+          throw runtime_error("write " + to_string(i));
+        ++written;
+      });
+    BOOST_ERROR("no error");
+  } catch (runtime_error &e) {
+    const char *names[] = {"read ", "translate ", "write "};
+    BOOST_CHECK_EQUAL(e.what(), names[static_cast<int>(stage)] + to_string(failAt));
+  }
+  BOOST_CHECK_LE(written, failAt);
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_errors, *utf::timeout(30)) {
+  for (Stage stage: {Stage::READ, Stage::TRANSLATE, Stage::WRITE}) {
+    // first item, within the window, and well past it.
+    for (size_t failAt: {0, 2, 30}) {
+      BOOST_TEST_CONTEXT("stage " << static_cast<int>(stage) << " at " << failAt) {
+        checkFails(stage, 40, failAt);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_pipeline_every_translate_fails, *utf::timeout(30)) {
+  // all workers fail at once; one error comes out.
+  BOOST_CHECK_THROW(
+    (pipeline<int, int>(
+      100, 4, 8,
+      [](size_t i) { return static_cast<int>(i); },
+      [](int, size_t, int &) -> int { throw runtime_error("fail"); },
+      [](size_t, int &) { })),
+    runtime_error);
+}
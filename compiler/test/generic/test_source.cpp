@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/source.h"
+
+using namespace std;
+
+static vector<string> lines(string_view text) {
+  LineIndex index;
+  indexLines(index, text);
+  return vector<string>(index.begin(), index.end());
+}
+
+// indexLines
+
+BOOST_AUTO_TEST_CASE(test_index_lines) {
+  vector<string> expected = {"push constant 1", "add", ""};
+  BOOST_CHECK(lines("push constant 1\nadd\n") == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_index_lines_no_trailing_newline) {
+  vector<string> expected = {"push constant 1", "add"};
+  BOOST_CHECK(lines("push constant 1\nadd") == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_index_lines_empty) {
+  vector<string> expected = {""};
+  BOOST_CHECK(lines("") == expected);
+  expected = {"", ""};
+  BOOST_CHECK(lines("\n") == expected);
+  expected = {"", "", ""};
+  BOOST_CHECK(lines("\n\n") == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_index_lines_crlf) {
+  // like std::getline, the '\r' stays for the builders to strip.
+  vector<string> expected = {"@2\r", "D=A\r", "0;JMP"};
+  BOOST_CHECK(lines("@2\r\nD=A\r\n0;JMP") == expected);
+}
+
+BOOST_AUTO_TEST_CASE(test_index_lines_views_into_text) {
+  string text = "a\nbc\n";
+  LineIndex index;
+  indexLines(index, text);
+  BOOST_CHECK(index[1].data() == text.data() + 2);
+  // the index is rebuilt, not appended to.
+  indexLines(index, "x");
+  BOOST_CHECK_EQUAL(index.size(), 1);
+}
+
+// SourceBuffer
+
+// writes a file next to the test binary and removes it after.
+struct fixture {
+  const string path = "test_source.txt";
+
+  void writeFile(const string &text) {
+    ofstream out(path, ios::binary);
+    out << text;
+  }
+
+  vector<string> read() {
+    SourceBuffer source(path);
+    const LineIndex &index = source.lines();
+    return vector<string>(index.begin(), index.end());
+  }
+
+  ~fixture() {
+    remove(path.c_str());
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_source_same_as_index_lines, fixture) {
+  for (string text: {"add\nneg\n", "add\nneg", "@2\r\nD=A\r\n", "\n"}) {
+    writeFile(text);
+    BOOST_CHECK(read() == lines(text));
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(test_source_empty_file, fixture) {
+  // can't be mmap-ed, gets read instead.
+  writeFile("");
+  SourceBuffer source(path);
+  BOOST_CHECK(source.contents().empty());
+  BOOST_CHECK_EQUAL(source.lines().size(), 1);
+  BOOST_CHECK(source.lines()[0].empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_source_missing_file, fixture) {
+  try {
+    SourceBuffer source(path);
+    BOOST_ERROR("no error for a missing file");
+  } catch (runtime_error &e) {
+    BOOST_CHECK_EQUAL(e.what(), "Cannot open file " + path + "\n");
+  }
+}
@@ -0,0 +1,222 @@
+#include <climits>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/utils.h"
+
+using namespace std;
+
+// parseNumber
+
+static void checkParsed(string_view s, int value, int min = INT_MIN, int max = INT_MAX) {
+  ParsedNumber num = parseNumber(s, min, max);
+  BOOST_CHECK_MESSAGE(num.ok(), "\"" << s << "\" should parse");
+  BOOST_CHECK_EQUAL(num.value, value);
+}
+
+static void checkError(string_view s, NumberError error, int min = INT_MIN, int max = INT_MAX) {
+  ParsedNumber num = parseNumber(s, min, max);
+  BOOST_CHECK_MESSAGE(num.error == error, "\"" << s << "\" gives " << numberErrorName(num.error));
+  BOOST_CHECK_EQUAL(num.value, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_number_signs) {
+  checkParsed("5", 5);
+  checkParsed("+5", 5);
+  checkParsed("-5", -5);
+  checkParsed("-0", 0);
+  checkParsed("007", 7);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_number_invalid) {
+  checkError("", NumberError::INVALID);
+  checkError("+", NumberError::INVALID);
+  checkError("-", NumberError::INVALID);
+  checkError("+-5", NumberError::INVALID);
+  checkError("-+5", NumberError::INVALID);
+  checkError("12a", NumberError::INVALID);
+  checkError("a12", NumberError::INVALID);
+  checkError(" 12", NumberError::INVALID);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_number_int_limits) {
+  checkParsed("2147483647", INT_MAX);
+  checkParsed("-2147483648", INT_MIN);
+  checkError("2147483648", NumberError::OUT_OF_RANGE);
+  checkError("-2147483649", NumberError::OUT_OF_RANGE);
+  checkError("99999999999999999999", NumberError::OUT_OF_RANGE);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_number_hack_bounds) {
+  // what A-instructions and vm indexes take.
+  const int max = HACK_NUMBERS - 1;
+  checkParsed("0", 0, 0, max);
+  checkParsed("32767", 32767, 0, max);
+  checkError("32768", NumberError::OUT_OF_RANGE, 0, max);
+  checkError("-1", NumberError::OUT_OF_RANGE, 0, max);
+  checkError("12a", NumberError::INVALID, 0, max);
+}
+
+// formatNumber
+
+static bool inBuffer(string_view text, const NumberBuffer &buf) {
+  return text.data() >= buf && text.data() + text.size() <= buf + sizeof(buf);
+}
+
+BOOST_AUTO_TEST_CASE(test_format_number_table) {
+  NumberBuffer buf;
+  BOOST_CHECK_EQUAL(formatNumber(0, buf), "0");
+  BOOST_CHECK_EQUAL(formatNumber(9, buf), "9");
+  BOOST_CHECK_EQUAL(formatNumber(10, buf), "10");
+  string_view last = formatNumber(HACK_NUMBERS - 1, buf);
+  BOOST_CHECK_EQUAL(last, "32767");
+  BOOST_CHECK(!inBuffer(last, buf));
+}
+
+BOOST_AUTO_TEST_CASE(test_format_number_past_table) {
+  NumberBuffer buf;
+  string_view first = formatNumber(HACK_NUMBERS, buf);
+  BOOST_CHECK_EQUAL(first, "32768");
+  BOOST_CHECK(inBuffer(first, buf));
+  BOOST_CHECK_EQUAL(formatNumber(1000000007, buf), "1000000007");
+  BOOST_CHECK_EQUAL(formatNumber(LLONG_MAX, buf), "9223372036854775807");
+}
+
+BOOST_AUTO_TEST_CASE(test_format_number_negative) {
+  NumberBuffer buf;
+  BOOST_CHECK_EQUAL(formatNumber(-1, buf), "-1");
+  BOOST_CHECK_EQUAL(formatNumber(-32767, buf), "-32767");
+  BOOST_CHECK_EQUAL(formatNumber(-32768, buf), "-32768");
+  BOOST_CHECK_EQUAL(formatNumber(LLONG_MIN, buf), "-9223372036854775808");
+}
+
+BOOST_AUTO_TEST_CASE(test_append_number) {
+  string out = "@";
+  appendNumber(out, 32767);
+  BOOST_CHECK_EQUAL(out, "@32767");
+  appendNumber(out, -5);
+  BOOST_CHECK_EQUAL(out, "@32767-5");
+  BOOST_CHECK_EQUAL(withNumber("R", 15), "R15");
+  BOOST_CHECK_EQUAL(withNumber("x", LLONG_MIN), "x-9223372036854775808");
+}
+
+// split
+
+BOOST_AUTO_TEST_CASE(test_split_views) {
+  string line = "push constant 7";
+  vector<string_view> parts;
+  split(parts, line, " ");
+  vector<string_view> expected = {"push", "constant", "7"};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+  // views into line, nothing got copied.
+  BOOST_CHECK(parts[0].data() == line.data());
+  BOOST_CHECK(parts[2].data() == line.data() + line.size() - 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_split_empty) {
+  vector<string> parts;
+  split(parts, "", " ");
+  vector<string> expected = {""};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+}
+
+BOOST_AUTO_TEST_CASE(test_split_all_delimiters) {
+  // only the part after the last delimiter is kept even if empty.
+  vector<string> parts;
+  split(parts, "   ", " ");
+  vector<string> expected = {""};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+}
+
+BOOST_AUTO_TEST_CASE(test_split_multichar_delimiter) {
+  vector<string_view> parts;
+  split(parts, "a, b,, c", ", ");
+  vector<string_view> expected = {"a", "b,", "c"};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+}
+
+BOOST_AUTO_TEST_CASE(test_split_by_any_char) {
+  deque<string> parts;
+  split_by_any_char(parts, "a.b(c)", ".()");
+  deque<string> expected = {"a", "b", "c", ""};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+}
+
+BOOST_AUTO_TEST_CASE(test_split_by_any_char_keep_elements) {
+  vector<string_view> parts;
+  split_by_any_char(parts, "a.b(c)", ".()", true);
+  vector<string_view> expected = {"a", ".", "b", "(", "c", ")", ""};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+}
+
+BOOST_AUTO_TEST_CASE(test_split_by_any_char_empty) {
+  vector<string_view> parts;
+  split_by_any_char(parts, "", " \t", true);
+  vector<string_view> expected = {""};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+}
+
+BOOST_AUTO_TEST_CASE(test_split_by_any_char_all_delimiters) {
+  vector<string_view> parts;
+  split_by_any_char(parts, " \t ", " \t");
+  vector<string_view> expected = {""};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+
+  parts.clear();
+  split_by_any_char(parts, "\"\"", "\"", true);
+  expected = {"\"", "\"", ""};
+  BOOST_REQUIRE_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                  begin(parts), end(parts));
+}
+
+// strip
+
+BOOST_AUTO_TEST_CASE(test_strip_views) {
+  BOOST_CHECK_EQUAL(lstrip_view(" \tab \t", " \t"), "ab \t");
+  BOOST_CHECK_EQUAL(rstrip_view(" \tab \t", " \t"), " \tab");
+  BOOST_CHECK_EQUAL(strip_view(" \tab \t", " \t"), "ab");
+  BOOST_CHECK_EQUAL(strip_view("ab", " "), "ab");
+  BOOST_CHECK_EQUAL(trim_view("\n a b \r"), "a b");
+}
+
+BOOST_AUTO_TEST_CASE(test_strip_views_empty) {
+  BOOST_CHECK_EQUAL(lstrip_view("", " "), "");
+  BOOST_CHECK_EQUAL(rstrip_view("", " "), "");
+  BOOST_CHECK_EQUAL(strip_view("", " "), "");
+  BOOST_CHECK_EQUAL(trim_view(""), "");
+}
+
+BOOST_AUTO_TEST_CASE(test_strip_views_all_chars) {
+  BOOST_CHECK_EQUAL(lstrip_view(" \t ", " \t"), "");
+  BOOST_CHECK_EQUAL(rstrip_view(" \t ", " \t"), "");
+  BOOST_CHECK_EQUAL(strip_view(" \t ", " \t"), "");
+  BOOST_CHECK_EQUAL(trim_view(" \t\n"), "");
+}
+
+BOOST_AUTO_TEST_CASE(test_strip_copies_match_views) {
+  BOOST_CHECK_EQUAL(lstrip_copy("xxaxx", "x"), "axx");
+  BOOST_CHECK_EQUAL(rstrip_copy("xxaxx", "x"), "xxa");
+  BOOST_CHECK_EQUAL(strip_copy("xxaxx", "x"), "a");
+  BOOST_CHECK_EQUAL(strip_copy("xxxx", "x"), "");
+}
+
+BOOST_AUTO_TEST_CASE(test_trim_non_ascii) {
+  // bytes of UTF-8 text aren't spaces, e.g. the second of U+00A0.
+  BOOST_CHECK_EQUAL(trim_view(" \xc2\xa0x\xc3\xa9 "), "\xc2\xa0x\xc3\xa9");
+  BOOST_CHECK_EQUAL(trim_copy("\t\xe2\x9c\x93\n"), "\xe2\x9c\x93");
+  BOOST_CHECK(isNumber("1"));
+  BOOST_CHECK(!isNumber("1\xd9\xa3"));
+}
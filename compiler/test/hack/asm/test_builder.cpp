@@ -0,0 +1,351 @@
+#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/line_buffer.h"
+#include "generic/source.h"
+#include "hack/asm/builder.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+struct fixture {
+  vector<string> expected;
+  vector<string> actual;
+  bool check = true;
+
+  // "-" keeps the assembler from writing an .asm_debug file.
+  vector<string> assemble(const string &program, int jobs = 1) {
+    LineIndex lines;
+    indexLines(lines, program);
+    HackAssembler assembler("-");
+    assembler.setJobs(jobs);
+    LineBuffer out = run(assembler, lines);
+    vector<string> words;
+    for (size_t i = 0; i < out.size(); ++i)
+      words.emplace_back(out[i]);
+    return words;
+  }
+
+  // the same, as words instead of text.
+  vector<string> assembleWords(const string &program, int jobs = 1) {
+    LineIndex lines;
+    indexLines(lines, program);
+    HackAssembler assembler("-");
+    assembler.setJobs(jobs);
+    assembler.setWordsOnly(true);
+    BOOST_CHECK_EQUAL(run(assembler, lines).size(), 0u);
+    vector<string> words;
+    for (uint16_t word: assembler.takeWords())
+      words.push_back(bitset<16>(word).to_string());
+    return words;
+  }
+
+  LineBuffer run(HackAssembler &assembler, const LineIndex &lines) {
+    assembler.reset();
+    assembler.setLines(&lines);
+    assembler.setInputFile("-");
+    return assembler.getResult();
+  }
+
+  void checkError(const string &program, const string &error) {
+    check = false;
+    try {
+      assemble(program);
+      BOOST_ERROR("no error for " + program);
+    } catch (runtime_error &e) {
+      BOOST_CHECK_EQUAL(e.what(), error);
+    }
+  }
+
+  virtual ~fixture() {
+    if (check)
+      BOOST_REQUIRE_EQUAL_COLLECTIONS(
+        begin(expected), end(expected),
+        begin(actual), end(actual));
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_numbers_and_computations, fixture) {
+  actual = assemble(
+    "// adds 2 and 3\n"
+    "@2\n"
+    "D=A\n"
+    "@3\n"
+    "D=D+A   // same as A+D\n"
+    "@0\n"
+    "M=D\n");
+  expected = {
+    "0000000000000010",
+    "1110110000010000",
+    "0000000000000011",
+    "1110000010010000",
+    "0000000000000000",
+    "1110001100001000",
+  };
+}
+
+BOOST_FIXTURE_TEST_CASE(test_commutative_spellings, fixture) {
+  // the comp table takes YopX for every XopY of + & and |, some of
+  // which the old assembler rejected; each is the same word as XopY.
+  actual = assemble(
+    "D=1+D\n"
+    "M=M&D\n"
+    "D=A+D\n"
+    "D=M|D\n"
+    "D=A&D\n"
+    "AM=A|D\n"
+    "D=M+D;JGT\n");
+  expected = assemble(
+    "D=D+1\n"
+    "M=D&M\n"
+    "D=D+A\n"
+    "D=D|M\n"
+    "D=D&A\n"
+    "AM=D|A\n"
+    "D=D+M;JGT\n");
+  BOOST_CHECK_EQUAL(actual.size(), 7u);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_backward_and_forward_labels, fixture) {
+  actual = assemble(
+    "(START)\n"
+    "@END\n"
+    "0;JMP\n"
+    "@START\n"
+    "0;JMP\n"
+    "(END)\n"
+    "@END\n"
+    "0;JMP\n");
+  expected = {
+    "0000000000000100",  // END is instruction 4, defined further down
+    "1110101010000111",
+    "0000000000000000",
+    "1110101010000111",
+    "0000000000000100",
+    "1110101010000111",
+  };
+}
+
+BOOST_FIXTURE_TEST_CASE(test_variables_from_16, fixture) {
+  actual = assemble(
+    "@i\n"
+    "@sum\n"
+    "@i\n"
+    "@LOOP\n"   // a label, not a variable, though used before it's defined
+    "(LOOP)\n"
+    "@j\n");
+  expected = {
+    "0000000000010000",  // i = 16
+    "0000000000010001",  // sum = 17
+    "0000000000010000",
+    "0000000000000100",  // LOOP = 4
+    "0000000000010010",  // j = 18
+  };
+}
+
+BOOST_FIXTURE_TEST_CASE(test_predefined_symbols, fixture) {
+  actual = assemble(
+    "@SP\n@LCL\n@ARG\n@THIS\n@THAT\n"
+    "@R0\n@R7\n@R15\n"
+    "@SCREEN\n@KBD\n"
+    "@R16\n");  // not a register, so a variable
+  expected = {
+    "0000000000000000",
+    "0000000000000001",
+    "0000000000000010",
+    "0000000000000011",
+    "0000000000000100",
+    "0000000000000000",
+    "0000000000000111",
+    "0000000000001111",
+    "0100000000000000",
+    "0110000000000000",
+    "0000000000010000",
+  };
+}
+
+BOOST_FIXTURE_TEST_CASE(test_assembles_again_from_scratch, fixture) {
+  // symbols of a run don't leak into the next one.
+  string program = "@x\n(L)\n@L\n";
+  expected = assemble(program);
+  actual = assemble(program);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_label_defined_twice, fixture) {
+  checkError("(A1)\n@A1\n(A1)\n", "Symbol defined twice: (A1)\n");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_predefined_redefined, fixture) {
+  checkError("@1\n(SP)\n", "Symbol defined twice: (SP)\n");
+  checkError("(R3)\n", "Symbol defined twice: (R3)\n");
+  checkError("(SCREEN)\n", "Symbol defined twice: (SCREEN)\n");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_invalid_lines, fixture) {
+  checkError("@1\nD=Q\n", "Error parsing line: 2\n");
+  checkError("@32768\n", "Error parsing line: 1\n");
+  checkError("DM=A\n", "Error parsing line: 1\n");
+}
+
+// A program long enough for setJobs() to split it into chunks, with
+// symbols used in one chunk and defined, or first used, in others.
+struct long_program {
+  string text;
+  int instructions = 0;
+
+  void instruction(const string &line) {
+    text += line + "\n";
+    ++instructions;
+  }
+
+  // where the next instruction goes.
+  int label(const string &name) {
+    text += "(" + name + ")\n";
+    return instructions;
+  }
+
+  void fill(int lines) {
+    for (int i = 0; i < lines; ++i)
+      instruction(i % 2 ? "D=D+1" : "@" + to_string(i % 1000));
+  }
+};
+
+static string word(int value) {
+  return bitset<16>(value).to_string();
+}
+
+BOOST_FIXTURE_TEST_CASE(test_chunks_same_as_single_pass, fixture) {
+  long_program p;
+  p.instruction("@END");      // 0, defined in the last chunk
+  p.instruction("@first");    // 1, variable 16
+  int start = p.label("START");
+  p.fill(3000);
+  int secondAt = p.instructions;
+  p.instruction("@second");   // variable 17
+  int middleAt = p.instructions;
+  p.instruction("@MIDDLE");   // defined a few chunks further
+  p.fill(3000);
+  int firstAgainAt = p.instructions;
+  p.instruction("@first");
+  p.fill(3000);
+  int middle = p.label("MIDDLE");
+  p.fill(2000);
+  int startAt = p.instructions;
+  p.instruction("@START");    // defined in the first chunk
+  int thirdAt = p.instructions;
+  p.instruction("@third");    // variable 18
+  int end = p.label("END");
+  p.instruction("@END");
+  p.instruction("0;JMP");
+
+  actual = assemble(p.text, 4);
+  expected = assemble(p.text, 1);
+  BOOST_REQUIRE_EQUAL(actual.size(), size_t(p.instructions));
+  BOOST_CHECK_EQUAL(actual[0], word(end));
+  BOOST_CHECK_EQUAL(actual[1], word(16));
+  BOOST_CHECK_EQUAL(actual[secondAt], word(17));
+  BOOST_CHECK_EQUAL(actual[middleAt], word(middle));
+  BOOST_CHECK_EQUAL(actual[firstAgainAt], word(16));
+  BOOST_CHECK_EQUAL(actual[startAt], word(start));
+  BOOST_CHECK_EQUAL(actual[thirdAt], word(18));
+  BOOST_CHECK_EQUAL(actual[p.instructions - 1], "1110101010000111");
+
+  // words handed over as they are, by both paths.
+  vector<string> words = assembleWords(p.text, 4);
+  BOOST_CHECK(words == expected);
+  words = assembleWords(p.text, 1);
+  BOOST_CHECK(words == expected);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_chunked_words_with_forward_labels, fixture) {
+  // every label is jumped to a few hundred lines before it's defined,
+  // so many of those jumps cross into a later chunk, and some
+  // variables come in between.
+  long_program p;
+  vector<int> jumps;
+  vector<int> labels;
+  for (int k = 0; k < 40; ++k) {
+    jumps.push_back(p.instructions);
+    p.instruction("@NEXT" + to_string(k));
+    p.instruction("0;JMP");
+    p.instruction("@var" + to_string(k % 5));
+    p.fill(400);
+    labels.push_back(p.label("NEXT" + to_string(k)));
+  }
+
+  check = false;
+  vector<string> serial = assembleWords(p.text, 1);
+  vector<string> chunked = assembleWords(p.text, 4);
+  BOOST_REQUIRE_EQUAL(serial.size(), size_t(p.instructions));
+  BOOST_CHECK(chunked == serial);
+  for (size_t k = 0; k < jumps.size(); ++k) {
+    BOOST_CHECK_EQUAL(chunked[jumps[k]], word(labels[k]));
+    BOOST_CHECK_EQUAL(chunked[jumps[k] + 2], word(16 + k % 5));
+  }
+}
+
+static string readFile(const fs::path &path) {
+  ifstream in(path, ios::binary);
+  ostringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+BOOST_FIXTURE_TEST_CASE(test_chunked_debug_file, fixture) {
+  check = false;
+  const fs::path dir = "test_asm_debug_dir";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  long_program p;
+  p.instruction("@END");
+  p.fill(10000);
+  p.label("END");
+  p.instruction("0;JMP");
+  LineIndex lines;
+  indexLines(lines, p.text);
+
+  // chunks write the same .asm_debug as a single pass.
+  for (int jobs: {1, 4}) {
+    HackAssembler assembler((dir / ("Jobs" + to_string(jobs) + ".asm")).string());
+    assembler.setJobs(jobs);
+    run(assembler, lines);
+  }
+  string serial = readFile(dir / "Jobs1.asm_debug");
+  BOOST_CHECK(serial.rfind("0 @END\n", 0) == 0);
+  BOOST_CHECK(serial == readFile(dir / "Jobs4.asm_debug"));
+  fs::remove_all(dir);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_chunks_report_first_error, fixture) {
+  long_program p;
+  p.fill(5000);
+  p.label("TWICE");
+  p.fill(5000);
+  p.instruction("D=Q");
+  p.label("TWICE");
+  p.fill(100);
+
+  // the bad line is met before the second (TWICE), with or without
+  // chunks.
+  for (int jobs: {1, 4}) {
+    check = false;
+    LineIndex lines;
+    indexLines(lines, p.text);
+    HackAssembler assembler("-");
+    assembler.setJobs(jobs);
+    BOOST_CHECK_EXCEPTION(run(assembler, lines), runtime_error,
+                          [](const runtime_error &e) {
+                            return string(e.what()) == "Error parsing line: 10002\n";
+                          });
+  }
+}
@@ -0,0 +1,134 @@
+#include <bitset>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "hack/asm/translator.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// a program split over two files of a dir, and the same program in a
+// single file next to it; removed after.
+struct fixture {
+  const fs::path dir = "test_asm_translator_dir";
+  const fs::path split = dir / "Split";
+  const fs::path whole = dir / "Whole.asm";
+  const string first =
+    "(START)\n"
+    "@x\n"
+    "M=1\n"
+    "@START\n"
+    "0;JMP\n";
+  // uses its own label, a new variable and the other file's label.
+  const string second =
+    "(LOOP)\n"
+    "@y\n"
+    "M=1\n"
+    "@LOOP\n"
+    "0;JMP\n"
+    "@START\n"
+    "0;JMP\n";
+
+  fixture() {
+    fs::remove_all(dir);
+    fs::create_directories(split);
+    writeFile(split / "a.asm", first);
+    writeFile(split / "b.asm", second);
+    writeFile(whole, first + second);
+  }
+  ~fixture() { fs::remove_all(dir); }
+
+  static void writeFile(const fs::path &path, const string &text) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out << text;
+  }
+
+  static string readFile(const fs::path &path) {
+    ifstream in(path, ios::binary);
+    ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+  }
+
+  static vector<string> lines(const string &text) {
+    vector<string> found;
+    istringstream in(text);
+    for (string line; getline(in, line);)
+      found.push_back(line);
+    return found;
+  }
+
+  // the output of AsmHack on path, with -o output.
+  string assemble(const fs::path &path, const fs::path &output,
+                  const string &format = "text", int jobs = 1) {
+    AsmHackTranslator translator(path.string());
+    translator.setJobs(jobs);
+    translator.setOutputFile(output.string());
+    translator.setFormat(format);
+    translator.translate();
+    return readFile(output);
+  }
+};
+
+static string word(int value) {
+  return bitset<16>(value).to_string();
+}
+
+BOOST_FIXTURE_TEST_CASE(test_files_are_one_program, fixture) {
+  string text = assemble(split, dir / "split.hack");
+  BOOST_CHECK_EQUAL(text, assemble(whole, dir / "whole.hack"));
+
+  // b's labels go on from where a ends, y comes after x, and START
+  // is a's label, not a variable; no empty lines between the files.
+  vector<string> words = lines(text);
+  BOOST_REQUIRE_EQUAL(words.size(), 10u);
+  BOOST_CHECK_EQUAL(words[0], word(16));  // @x
+  BOOST_CHECK_EQUAL(words[2], word(0));   // @START
+  BOOST_CHECK_EQUAL(words[4], word(17));  // @y
+  BOOST_CHECK_EQUAL(words[6], word(4));   // @LOOP
+  BOOST_CHECK_EQUAL(words[8], word(0));   // @START
+}
+
+BOOST_FIXTURE_TEST_CASE(test_words_of_one_program, fixture) {
+  // bin is the words of the same single program, not of each file.
+  string bin = assemble(split, dir / "split.bin", "bin");
+  BOOST_CHECK(bin == assemble(whole, dir / "whole.bin", "bin"));
+  BOOST_REQUIRE_EQUAL(bin.size(), 20u);
+  // @LOOP, big-endian.
+  BOOST_CHECK_EQUAL(bin[12], 0);
+  BOOST_CHECK_EQUAL(bin[13], 4);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_long_split_program_on_threads, fixture) {
+  // long enough to be assembled in chunks, with labels used in one
+  // file and defined in the other, both ways, and variables in both.
+  string a = "@B_END\n0;JMP\n(A_START)\n@a\n";
+  string b = "(B_START)\n@b\n@A_START\n0;JMP\n";
+  for (int i = 0; i < 6000; ++i) {
+    a += i % 2 ? "D=D+1\n" : "@B_START\n";
+    b += i % 2 ? "D=D-1\n" : "@A_START\n";
+  }
+  b += "(B_END)\n@a\n";
+  writeFile(split / "a.asm", a);
+  writeFile(split / "b.asm", b);
+  writeFile(whole, a + b);
+
+  string serial = assemble(whole, dir / "whole.hack");
+  string chunked = assemble(split, dir / "split.hack", "text", 4);
+  BOOST_CHECK(chunked == serial);
+  vector<string> words = lines(chunked);
+  int aEnd = 2 + 1 + 6000;
+  BOOST_REQUIRE_EQUAL(words.size(), size_t(aEnd + 1 + 2 + 6000 + 1));
+  BOOST_CHECK_EQUAL(words[0], word(words.size() - 1));  // @B_END
+  BOOST_CHECK_EQUAL(words[2], word(16));                // @a
+  BOOST_CHECK_EQUAL(words[3], word(aEnd));              // @B_START
+  BOOST_CHECK_EQUAL(words[aEnd], word(17));             // @b
+  BOOST_CHECK_EQUAL(words[aEnd + 1], word(2));          // @A_START
+  BOOST_CHECK_EQUAL(words.back(), word(16));            // @a again
+}
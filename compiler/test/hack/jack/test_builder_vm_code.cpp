@@ -397,8 +397,8 @@ BOOST_FIXTURE_TEST_CASE(test_if_statement, fixture) {
     "}\n"
   "}"
   );
-  std::string L0 = "IF_FALSE2";
-  std::string L1 = "IF_TRUE3";
+  std::string L0 = "IF_FALSE0";
+  std::string L1 = "IF_TRUE1";
   expected = {
     VMCommands::Function("Test.test", 0),
     VMCommands::Push("argument", 0),
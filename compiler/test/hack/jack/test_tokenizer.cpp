@@ -1,4 +1,5 @@
 #include <iterator>
+#include <stdexcept>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -6,26 +7,46 @@
 #define BOOST_TEST_MAIN
 #include <boost/test/included/unit_test.hpp>
 
+#include "generic/source.h"
 #include "hack/jack/tokenizer.h"
 
 using namespace std;
 
+// every case goes through both constructors: the stream one, and the
+// LineIndex one the compiler uses over an mmap-ed file.
 struct fixture {
   vector<string> expected;
   vector<string> actual;
+  vector<string> actualFromLines;
+  vector<int> lineNos;
 
-  void tokenize(istringstream &stream) {
-    JackTokenizer tok(stream);
+  static void read(JackTokenizer &tok, vector<string> &out, vector<int> *lineNos) {
     while (tok.hasMore()) {
-      actual.push_back(tok.getCurrentToken().value());
+      out.push_back(tok.getCurrentToken().value());
+      if (lineNos)
+        lineNos->push_back(tok.getCurrentToken().getLineNo());
       tok.advance();
     }
   }
 
+  void tokenize(istringstream &stream) {
+    string text = stream.str();
+    JackTokenizer tok(stream);
+    read(tok, actual, nullptr);
+
+    LineIndex lines;
+    indexLines(lines, text);
+    JackTokenizer fromLines(lines);
+    read(fromLines, actualFromLines, &lineNos);
+  }
+
   virtual ~fixture() {
     BOOST_REQUIRE_EQUAL_COLLECTIONS(
       begin(expected), end(expected),
       begin(actual), end(actual));
+    BOOST_REQUIRE_EQUAL_COLLECTIONS(
+      begin(expected), end(expected),
+      begin(actualFromLines), end(actualFromLines));
   }
 };
 
@@ -156,3 +177,102 @@ BOOST_FIXTURE_TEST_CASE(test_class_with_comments, fixture) {
 
   tokenize(stream);
 }
+
+BOOST_FIXTURE_TEST_CASE(test_multiline_comment_mid_line, fixture) {
+  istringstream stream("let x /* the x */ = 1; return;");
+  expected = {"let", "x", "=", "1", ";", "return", ";"};
+
+  tokenize(stream);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_multiline_comment_mid_line_with_string, fixture) {
+  istringstream stream("do f(\"a b\" /* , \"c\" */, x);");
+  expected = {"do", "f", "(", "\"a b\"", ",", "x", ")", ";"};
+
+  tokenize(stream);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_multiline_comment_spanning_lines, fixture) {
+  istringstream stream(
+    "let a = 1; /* starts here\n"
+    "   let b = 2;\n"
+    "ends here */ let c = 3;\n"
+    "let d = 4;");
+  expected = {"let", "a", "=", "1", ";", "let", "c", "=", "3", ";",
+              "let", "d", "=", "4", ";"};
+
+  tokenize(stream);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_string_next_to_symbols, fixture) {
+  istringstream stream("do f(\"(a);\",\"b.c\");");
+  expected = {"do", "f", "(", "\"(a);\"", ",", "\"b.c\"", ")", ";"};
+
+  tokenize(stream);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_last_line_with_newline, fixture) {
+  istringstream stream("let x = 1;\nreturn;\n");
+  expected = {"let", "x", "=", "1", ";", "return", ";"};
+
+  tokenize(stream);
+  vector<int> expectedLineNos = {1, 1, 1, 1, 1, 2, 2};
+  BOOST_CHECK(lineNos == expectedLineNos);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_last_line_without_newline, fixture) {
+  istringstream stream("let x = 1;\n\nreturn;");
+  expected = {"let", "x", "=", "1", ";", "return", ";"};
+
+  tokenize(stream);
+  vector<int> expectedLineNos = {1, 1, 1, 1, 1, 3, 3};
+  BOOST_CHECK(lineNos == expectedLineNos);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_no_more_after_end, fixture) {
+  LineIndex lines;
+  indexLines(lines, "return;");
+  JackTokenizer tok(lines);
+  read(tok, actual, nullptr);
+  // past the last line, it keeps saying there's nothing left.
+  BOOST_CHECK(!tok.hasMore());
+  BOOST_CHECK(!tok.hasMore());
+  actualFromLines = actual;
+  expected = {"return", ";"};
+}
+
+BOOST_FIXTURE_TEST_CASE(test_multiline_comments_mid_line_on_several_lines, fixture) {
+  // each line rebuilds the comment buffer the one before left behind.
+  istringstream stream(
+    "let x /* 1 */ = 1;\n"
+    "let yy /* 2 */ = \"s t\";\n"
+    "/* 3 */ return;");
+  expected = {"let", "x", "=", "1", ";",
+              "let", "yy", "=", "\"s t\"", ";",
+              "return", ";"};
+
+  tokenize(stream);
+  vector<int> expectedLineNos = {1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 3, 3};
+  BOOST_CHECK(lineNos == expectedLineNos);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_crlf_lines, fixture) {
+  istringstream stream("let x = 1;\r\n/* a */ return;\r\n");
+  expected = {"let", "x", "=", "1", ";", "return", ";"};
+
+  tokenize(stream);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_non_ascii_in_comments_and_strings, fixture) {
+  istringstream stream(
+    "// caf\xc3\xa9\n"
+    "do f(\"na\xc3\xafve\"); /* \xe2\x9c\x93 */ return;");
+  expected = {"do", "f", "(", "\"na\xc3\xafve\"", ")", ";", "return", ";"};
+
+  tokenize(stream);
+}
+
+BOOST_AUTO_TEST_CASE(test_non_ascii_identifier) {
+  BOOST_CHECK_THROW(Token::fromString("caf\xc3\xa9"), runtime_error);
+  BOOST_CHECK_THROW(Token::fromString("\xc3\xa9t\xc3\xa9"), runtime_error);
+}
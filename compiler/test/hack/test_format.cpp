@@ -0,0 +1,166 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "hack/format.h"
+
+using namespace std;
+
+static string bytes(const vector<int> &values) {
+  string out;
+  for (int value: values)
+    out.push_back(static_cast<char>(value));
+  return out;
+}
+
+static vector<string> hexRecords(const string &hex) {
+  vector<string> records;
+  size_t start = 0;
+  size_t end = 0;
+  while ((end = hex.find('\n', start)) != string::npos) {
+    records.push_back(hex.substr(start, end - start));
+    start = end + 1;
+  }
+  BOOST_CHECK_EQUAL(start, hex.size());  // ends in a newline
+  return records;
+}
+
+// all bytes of a record, the checksum included, add up to 0.
+static void checkChecksum(const string &record) {
+  BOOST_REQUIRE(record.size() >= 11 && record.size() % 2 == 1 && record[0] == ':');
+  uint8_t sum = 0;
+  for (size_t i = 1; i < record.size(); i += 2)
+    sum += static_cast<uint8_t>(stoi(record.substr(i, 2), nullptr, 16));
+  BOOST_CHECK_MESSAGE(sum == 0, record << " doesn't add up to 0");
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_format) {
+  BOOST_CHECK(parseHackFormat("text") == HackFormat::TEXT);
+  BOOST_CHECK(parseHackFormat("bin") == HackFormat::BIN);
+  BOOST_CHECK(parseHackFormat("hex") == HackFormat::HEX);
+  BOOST_CHECK(parseHackFormat("rom") == HackFormat::ROM);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_unknown_format) {
+  for (string name: {"", "BIN", "binary", "hack", " hex"}) {
+    try {
+      parseHackFormat(name);
+      BOOST_ERROR("no error for format '" + name + "'");
+    } catch (runtime_error &e) {
+      BOOST_CHECK_EQUAL(e.what(),
+        "Unknown format " + name + ", expected text, bin, hex or rom\n");
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_extension) {
+  BOOST_CHECK_EQUAL(hackExtension(HackFormat::TEXT), "hack");
+  BOOST_CHECK_EQUAL(hackExtension(HackFormat::BIN), "bin");
+  BOOST_CHECK_EQUAL(hackExtension(HackFormat::HEX), "hex");
+  BOOST_CHECK_EQUAL(hackExtension(HackFormat::ROM), "rom");
+}
+
+BOOST_AUTO_TEST_CASE(test_bin_big_endian) {
+  // @2, D=A, and a word with the top bit of each byte set.
+  vector<uint16_t> words = {0x0002, 0xEC10, 0x8180};
+  BOOST_CHECK_EQUAL(encodeHack(words, HackFormat::BIN),
+                    bytes({0x00, 0x02, 0xEC, 0x10, 0x81, 0x80}));
+  BOOST_CHECK_EQUAL(encodeHack({}, HackFormat::BIN), "");
+}
+
+BOOST_AUTO_TEST_CASE(test_rom_header) {
+  vector<uint16_t> words = {0x0002, 0xEC10, 0x8180};
+  // "HROM", version 1, 3 words, then the words as in bin.
+  BOOST_CHECK_EQUAL(encodeHack(words, HackFormat::ROM),
+                    "HROM" + bytes({0x00, 0x01, 0x00, 0x03}) +
+                    encodeHack(words, HackFormat::BIN));
+  BOOST_CHECK_EQUAL(encodeHack({}, HackFormat::ROM),
+                    "HROM" + bytes({0x00, 0x01, 0x00, 0x00}));
+  // the count is big-endian too.
+  vector<uint16_t> many(0x0123, 0);
+  string rom = encodeHack(many, HackFormat::ROM);
+  BOOST_CHECK_EQUAL(rom.substr(4, 4), bytes({0x00, 0x01, 0x01, 0x23}));
+  BOOST_CHECK_EQUAL(rom.size(), 8 + 0x0123 * 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_hex_record) {
+  // 4 bytes at 0000, data (00), 00 02 EC 10, then 0x100 - 0x02.
+  BOOST_CHECK_EQUAL(encodeHack({0x0002, 0xEC10}, HackFormat::HEX),
+                    ":040000000002EC10FE\n"
+                    ":00000001FF\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_hex_empty) {
+  BOOST_CHECK_EQUAL(encodeHack({}, HackFormat::HEX), ":00000001FF\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_hex_records_of_8_words) {
+  vector<uint16_t> words;
+  for (uint16_t i = 0; i < 17; ++i)
+    words.push_back(static_cast<uint16_t>(0xE000 | i));
+  vector<string> records = hexRecords(encodeHack(words, HackFormat::HEX));
+  BOOST_REQUIRE_EQUAL(records.size(), 4);
+  // length in bytes, byte address of the first word, type 00.
+  BOOST_CHECK_EQUAL(records[0].substr(0, 9), ":10000000");
+  BOOST_CHECK_EQUAL(records[1].substr(0, 9), ":10001000");
+  BOOST_CHECK_EQUAL(records[2].substr(0, 9), ":02002000");
+  BOOST_CHECK_EQUAL(records[0].substr(9, 8), "E000E001");
+  BOOST_CHECK_EQUAL(records[2].substr(9, 4), "E010");
+  BOOST_CHECK_EQUAL(records[0].size(), 11 + 16 * 2);
+  BOOST_CHECK_EQUAL(records[2].size(), 11 + 2 * 2);
+  BOOST_CHECK_EQUAL(records[3], ":00000001FF");
+  for (const string &record: records)
+    checkChecksum(record);
+}
+
+BOOST_AUTO_TEST_CASE(test_hex_last_address) {
+  // a full 32K program ends at byte 0xFFF0, still in 16 bits.
+  vector<uint16_t> words(32768, 0xFFFF);
+  vector<string> records = hexRecords(encodeHack(words, HackFormat::HEX));
+  BOOST_REQUIRE_EQUAL(records.size(), 32768 / 8 + 1);
+  const string &last = records[records.size() - 2];
+  BOOST_CHECK_EQUAL(last.substr(0, 9), ":10FFF000");
+  checkChecksum(last);
+  checkChecksum(records[1234]);
+}
+
+BOOST_AUTO_TEST_CASE(test_more_than_rom) {
+  // a full ROM still fits the header's count.
+  vector<uint16_t> words(HACK_ROM_WORDS, 0x0001);
+  BOOST_CHECK_EQUAL(encodeHack(words, HackFormat::ROM).substr(6, 2), bytes({0x80, 0x00}));
+  // one more would wrap it, and the hex addresses.
+  words.push_back(0x0001);
+  for (HackFormat format: {HackFormat::BIN, HackFormat::HEX, HackFormat::ROM}) {
+    try {
+      encodeHack(words, format);
+      BOOST_ERROR("no error for " + hackExtension(format));
+    } catch (runtime_error &e) {
+      BOOST_CHECK_EQUAL(e.what(),
+        "Program has 32769 instructions, more than the 32768 the ROM holds.\n");
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_text_not_encoded) {
+  BOOST_CHECK_THROW(encodeHack({0x0002}, HackFormat::TEXT), logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_write_hack) {
+  const string path = "test_format.bin";
+  vector<uint16_t> words = {0x0002, 0xEC10};
+  writeHack(words, HackFormat::ROM, path);
+  string written;
+  {
+    ifstream in(path, ios::binary);
+    written.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+  }
+  remove(path.c_str());
+  BOOST_CHECK_EQUAL(written, encodeHack(words, HackFormat::ROM));
+}
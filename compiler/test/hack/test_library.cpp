@@ -0,0 +1,149 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/line_buffer.h"
+#include "generic/source.h"
+#include "hack/library.h"
+
+using namespace std;
+
+// writes libraries next to the test binary and removes them after.
+struct fixture {
+  const string path = "test_library.hlib";
+
+  void writeFile(const string &text) {
+    ofstream out(path);
+    out << text;
+  }
+
+  LibraryClass vmClass(const string &name, const string &code) {
+    LibraryClass libraryClass;
+    libraryClass.name = name;
+    LineIndex lines;
+    indexLines(lines, code);
+    scanVMSymbols(lines, libraryClass);
+    libraryClass.code = code;
+    return libraryClass;
+  }
+
+  void checkBad(const string &text, const string &error) {
+    writeFile(text);
+    try {
+      Library library(path);
+      BOOST_ERROR("no error for " + text);
+    } catch (runtime_error &e) {
+      BOOST_CHECK_EQUAL(e.what(), error);
+    }
+  }
+
+  ~fixture() {
+    remove(path.c_str());
+  }
+};
+
+static vector<string> names(const vector<Linker::Needed> &needed) {
+  vector<string> out;
+  for (const Linker::Needed &n: needed)
+    out.push_back(n.libraryClass->name);
+  return out;
+}
+
+BOOST_FIXTURE_TEST_CASE(test_scan_vm_symbols, fixture) {
+  LibraryClass math = vmClass("Math",
+    "function Math.multiply 2\n"
+    "call Math.abs 1\n"
+    "call Memory.alloc 1\n"
+    "call Memory.alloc 1\n"
+    "function Math.abs 0\n");
+  vector<string> exports = {"Math.abs", "Math.multiply"};
+  vector<string> imports = {"Memory.alloc"};
+  BOOST_CHECK_EQUAL_COLLECTIONS(begin(exports), end(exports),
+                                begin(math.exports), end(math.exports));
+  BOOST_CHECK_EQUAL_COLLECTIONS(begin(imports), end(imports),
+                                begin(math.imports), end(math.imports));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_write_then_read, fixture) {
+  string mathCode = "function Math.multiply 0\ncall Memory.alloc 1\nreturn\n";
+  string memoryCode = "function Memory.alloc 0\nreturn\n";
+  string emptyCode = "";
+  Library::write(path, "vm", {vmClass("Math", mathCode),
+                              vmClass("Memory", memoryCode),
+                              vmClass("Empty", emptyCode)});
+
+  Library library(path);
+  BOOST_CHECK_EQUAL(library.stage(), "vm");
+  const vector<LibraryClass> &classes = library.classes();
+  BOOST_REQUIRE_EQUAL(classes.size(), 3u);
+  BOOST_CHECK_EQUAL(classes[0].name, "Math");
+  BOOST_CHECK_EQUAL(classes[0].code, mathCode);
+  BOOST_REQUIRE_EQUAL(classes[0].imports.size(), 1u);
+  BOOST_CHECK_EQUAL(classes[0].imports[0], "Memory.alloc");
+  BOOST_CHECK_EQUAL(classes[1].name, "Memory");
+  BOOST_CHECK_EQUAL(classes[1].code, memoryCode);
+  BOOST_REQUIRE_EQUAL(classes[1].exports.size(), 1u);
+  BOOST_CHECK_EQUAL(classes[1].exports[0], "Memory.alloc");
+  BOOST_CHECK_EQUAL(classes[2].name, "Empty");
+  BOOST_CHECK(classes[2].code.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_link_what_is_called, fixture) {
+  Library::write(path, "asm", {
+    vmClass("Math", "function Math.multiply 0\ncall Memory.alloc 1\n"),
+    vmClass("Memory", "function Memory.alloc 0\ncall Memory.deAlloc 1\n"
+                      "function Memory.deAlloc 0\n"),
+    vmClass("Screen", "function Screen.clear 0\n"),
+    vmClass("Sys", "function Sys.init 0\ncall Main.main 0\n"),
+  });
+
+  Linker linker;
+  linker.addLibrary(path);
+  LineBuffer program;
+  program.push_back("(Main.main)");
+  program.push_back("@Math.multiply  // a call");
+  program.push_back("0;JMP");
+  program.push_back("@counter");
+  linker.scan(program);
+
+  // Math, and Memory through Math; Sys calls Main.main but nothing
+  // calls Sys, and counter isn't in any library.
+  vector<string> expected = {"Math", "Memory"};
+  vector<string> actual = names(linker.resolve());
+  BOOST_CHECK_EQUAL_COLLECTIONS(begin(expected), end(expected),
+                                begin(actual), end(actual));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_link_nothing_needed, fixture) {
+  Library::write(path, "asm", {vmClass("Math", "function Math.multiply 0\n")});
+  Linker linker;
+  linker.addLibrary(path);
+  LineBuffer program;
+  program.push_back("(Math.multiply)");
+  program.push_back("@Math.multiply");
+  linker.scan(program);
+  BOOST_CHECK(linker.resolve().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_not_a_library, fixture) {
+  checkBad("", "Not an hcc library: " + path + "\n");
+  checkBad("hcc-lib 2 vm\n", "Not an hcc library: " + path + "\n");
+  checkBad("hcc-lib 1 hack\n", "Not an hcc library: " + path + "\n");
+}
+
+BOOST_FIXTURE_TEST_CASE(test_malformed_index, fixture) {
+  string bad = "Bad library " + path + " at line ";
+  checkBad("hcc-lib 1 vm\nclass Math\n", bad + "2\n");
+  checkBad("hcc-lib 1 vm\nclass Math x\n", bad + "2\n");
+  checkBad("hcc-lib 1 vm\nclass Math -1\n", bad + "2\n");
+  checkBad("hcc-lib 1 vm\nfunction Math.f 0\n", bad + "2\n");
+  // says 3 lines of code, only 1 follows.
+  checkBad("hcc-lib 1 vm\nclass Math 3\nexport Math.f\nfunction Math.f 0\n",
+           bad + "4\n");
+}
@@ -0,0 +1,173 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "generic/builder.h"
+#include "generic/cache.h"
+#include "generic/line_buffer.h"
+#include "generic/source.h"
+#include "hack/hcc/translator.h"
+#include "hack/translator.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+namespace utf = boost::unit_test;
+
+// a small program and a cache dir next to the test binary, removed
+// after.
+struct fixture {
+  const fs::path dir = "test_translator_dir";
+  const fs::path program = dir / "Prog";
+  const fs::path cacheDir = dir / "cache";
+
+  fixture() {
+    fs::remove_all(dir);
+    fs::create_directories(program);
+    writeFile(program / "Main.jack",
+      "class Main {\n"
+      "  function void main() {\n"
+      "    do Helper.twice(3);\n"
+      "    return;\n"
+      "  }\n"
+      "}\n");
+    writeFile(program / "Helper.jack",
+      "class Helper {\n"
+      "  function int twice(int x) {\n"
+      "    return x + x;\n"
+      "  }\n"
+      "}\n");
+  }
+  ~fixture() { fs::remove_all(dir); }
+
+  static void writeFile(const fs::path &path, const string &text) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out << text;
+  }
+
+  // cache entries, with the time each was last written.
+  map<fs::path, fs::file_time_type> entries() {
+    map<fs::path, fs::file_time_type> found;
+    for (const fs::directory_entry &e: fs::recursive_directory_iterator(cacheDir))
+      if (e.is_regular_file())
+        found[e.path()] = e.last_write_time();
+    return found;
+  }
+
+  void build(BuildCache &cache, const string &format) {
+    HccTranslator translator(program.string());
+    translator.setCache(&cache);
+    translator.setFormat(format);
+    translator.translate();
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(test_hcc_formats_share_cache, fixture) {
+  BuildCache cache(cacheDir.string());
+  build(cache, "text");
+  auto stored = entries();
+  BOOST_CHECK_EQUAL(stored.size(), 2u);  // one per class
+  BOOST_CHECK(fs::exists(program / "Prog.hack"));
+
+  // the classes' asm doesn't depend on the format, so every class is
+  // a hit: nothing gets stored again.
+  build(cache, "bin");
+  BOOST_CHECK(entries() == stored);
+  BOOST_CHECK(fs::exists(program / "Prog.bin"));
+}
+
+// goes through the jack files of a dir like a real tool, but its
+// translation throws whatever the test gives it.
+class ThrowingTranslator: public HackTranslator {
+public:
+  ThrowingTranslator(const string &path, function<void()> fail)
+    : HackTranslator(path), _fail(fail) { }
+protected:
+  virtual list<Builder*> createBuilders() override { return {}; }
+  virtual string getOutputFile() override { return _path + "/Prog.out"; }
+  virtual string extension() override { return "jack"; }
+  virtual LineBuffer translateSource(const string &, SourceBuffer &, int) override {
+    _fail();
+    return LineBuffer();
+  }
+  // --watch builds go straight to it too.
+  virtual void rebuild(const vector<string> &) override {
+    _fail();
+  }
+private:
+  function<void()> _fail;
+};
+
+BOOST_FIXTURE_TEST_CASE(test_pipeline_removes_tmp_output, fixture) {
+  // not only runtime errors: whatever stops it, nothing is left behind.
+  vector<function<void()>> failures = {
+    [] { throw runtime_error("runtime\n"); },
+    [] { throw logic_error("logic"); },
+    [] { throw bad_alloc(); },
+    [] { throw 1; },
+  };
+  for (function<void()> &fail: failures) {
+    ThrowingTranslator translator(program.string(), fail);
+    translator.setPipeline(true);
+    translator.setJobs(2);
+    bool thrown = false;
+    try {
+      translator.translate();
+    } catch (...) {
+      thrown = true;
+    }
+    BOOST_CHECK(thrown);
+    BOOST_CHECK(!fs::exists(program / "Prog.out.tmp"));
+    BOOST_CHECK(!fs::exists(program / "Prog.out"));
+  }
+}
+
+// ends watch(), which only returns by throwing; not a std::exception,
+// so watch() doesn't take it for a failed build.
+struct StopWatching { };
+
+BOOST_FIXTURE_TEST_CASE(test_watch_survives_any_build_error, fixture,
+                        *utf::timeout(30)) {
+  int builds = 0;
+  ThrowingTranslator translator(program.string(), [&] {
+    ++builds;
+    if (builds == 1)
+      throw logic_error("logic");
+    if (builds == 2)
+      throw bad_alloc();
+    throw StopWatching();
+  });
+
+  // saves a file over and over, so the watcher keeps waking up.
+  atomic<bool> done(false);
+  thread saver([&] {
+    while (!done) {
+      this_thread::sleep_for(chrono::milliseconds(50));
+      writeFile(program / "Main.jack", "class Main { }\n");
+    }
+  });
+  bool stopped = false;
+  try {
+    translator.watch();
+  } catch (StopWatching&) {
+    stopped = true;
+  } catch (...) {
+    // a failed build ended it, checked below.
+  }
+  done = true;
+  saver.join();
+  // neither error ended the watching, the third build did.
+  BOOST_CHECK(stopped);
+  BOOST_CHECK_EQUAL(builds, 3);
+}
@@ -0,0 +1,263 @@
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define BOOST_TEST_MAIN
+#include <boost/test/included/unit_test.hpp>
+
+#include "libhcc/libhcc.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// a small program in a dir next to the test binary, removed after;
+// the tools run over it to get what libhcc must give back.
+struct fixture {
+  const fs::path dir = "test_libhcc_dir";
+  // sorted, the way a directory gets listed.
+  const vector<hcc::Source> classes = {
+    {"Helper.jack",
+     "class Helper {\n"
+     "  function int twice(int x) {\n"
+     "    return x + x;  // doubled\n"
+     "  }\n"
+     "}\n"},
+    {"Main.jack",
+     "/** calls Helper */\n"
+     "class Main {\n"
+     "  function void main() {\n"
+     "    var int y;\n"
+     "    let y = Helper.twice(3);\n"
+     "    do Output.printString(\"y\");\n"
+     "    return;\n"
+     "  }\n"
+     "}\n"},
+  };
+
+  fixture() {
+    fs::remove_all(dir);
+    fs::create_directories(dir / "Prog");
+    for (const hcc::Source &source: classes)
+      writeFile(dir / "Prog" / source.name, source.text);
+  }
+  ~fixture() { fs::remove_all(dir); }
+
+  static void writeFile(const fs::path &path, const string &text) {
+    ofstream out(path, ios::binary);
+    out << text;
+  }
+
+  static string readFile(const fs::path &path) {
+    ifstream in(path, ios::binary);
+    BOOST_REQUIRE_MESSAGE(in, "no file " << path);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+  }
+
+  static void run(const string &tool, const fs::path &path) {
+    string command = tool + " " + path.string() + " > /dev/null 2>&1";
+    BOOST_REQUIRE_MESSAGE(system(command.c_str()) == 0, command);
+  }
+
+  static hcc::Options target(hcc::Target target, bool bootstrap = true) {
+    hcc::Options options;
+    options.target = target;
+    options.bootstrap = bootstrap;
+    return options;
+  }
+};
+
+static void checkDiagnostic(const hcc::Result &result, const string &file,
+                            const string &message) {
+  BOOST_CHECK(!result.ok());
+  BOOST_REQUIRE_EQUAL(result.diagnostics.size(), 1);
+  BOOST_CHECK_EQUAL(result.diagnostics[0].file, file);
+  BOOST_CHECK_EQUAL(result.diagnostics[0].message, message);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_compile_jack_to_vm, fixture) {
+  hcc::Result result = hcc::compileJack(classes, target(hcc::Target::VM));
+  BOOST_CHECK(result.ok());
+  run(JACK_COMPILER, dir / "Prog");
+  BOOST_REQUIRE_EQUAL(result.vm.size(), 2);
+  BOOST_CHECK_EQUAL(result.vm[0].name, "Helper.vm");
+  BOOST_CHECK_EQUAL(result.vm[1].name, "Main.vm");
+  for (const hcc::Source &vm: result.vm)
+    BOOST_CHECK_EQUAL(vm.text, readFile(dir / "Prog" / vm.name));
+  // later stages aren't reached.
+  BOOST_CHECK(result.asmCode.empty());
+  BOOST_CHECK(result.hack.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_compile_jack_to_asm, fixture) {
+  hcc::Result result = hcc::compileJack(classes, target(hcc::Target::ASM));
+  BOOST_CHECK(result.ok());
+  run(JACK_COMPILER, dir / "Prog");
+  run(VM_TRANSLATOR, dir / "Prog");
+  BOOST_CHECK_EQUAL(result.vm.size(), 2);
+  BOOST_CHECK_EQUAL(result.asmCode, readFile(dir / "Prog" / "Prog.asm"));
+  BOOST_CHECK(result.hack.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_compile_jack_to_hack, fixture) {
+  hcc::Result result = hcc::compileJack(classes);
+  BOOST_CHECK(result.ok());
+  run(JACK_COMPILER, dir / "Prog");
+  run(VM_TRANSLATOR, dir / "Prog");
+  run(ASM_HACK, dir / "Prog" / "Prog.asm");
+  BOOST_CHECK_EQUAL(result.asmCode, readFile(dir / "Prog" / "Prog.asm"));
+  BOOST_CHECK_EQUAL(result.hack, readFile(dir / "Prog" / "Prog.hack"));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_translate_vm, fixture) {
+  run(JACK_COMPILER, dir / "Prog");
+  vector<hcc::Source> files;
+  for (const char *name: {"Helper.vm", "Main.vm"})
+    files.push_back({name, readFile(dir / "Prog" / name)});
+
+  hcc::Result result = hcc::translateVM(files, target(hcc::Target::ASM));
+  BOOST_CHECK(result.ok());
+  run(VM_TRANSLATOR, dir / "Prog");
+  BOOST_CHECK(result.vm.empty());
+  BOOST_CHECK_EQUAL(result.asmCode, readFile(dir / "Prog" / "Prog.asm"));
+  BOOST_CHECK(result.hack.empty());
+
+  result = hcc::translateVM(files);
+  BOOST_CHECK(result.ok());
+  run(ASM_HACK, dir / "Prog" / "Prog.asm");
+  BOOST_CHECK_EQUAL(result.hack, readFile(dir / "Prog" / "Prog.hack"));
+
+  // vm is where translateVM starts, so the files come back as they are.
+  result = hcc::translateVM(files, target(hcc::Target::VM));
+  BOOST_CHECK(result.ok());
+  BOOST_REQUIRE_EQUAL(result.vm.size(), files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    BOOST_CHECK_EQUAL(result.vm[i].name, files[i].name);
+    BOOST_CHECK_EQUAL(result.vm[i].text, files[i].text);
+  }
+  BOOST_CHECK(result.asmCode.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_translate_vm_file_without_bootstrap, fixture) {
+  // a lone file gets no bootstrap code from VMTranslator either.
+  run(JACK_COMPILER, dir / "Prog");
+  hcc::Source main = {"Main.vm", readFile(dir / "Prog" / "Main.vm")};
+  hcc::Result result = hcc::translateVM({main}, target(hcc::Target::HACK, false));
+  BOOST_CHECK(result.ok());
+  run(VM_TRANSLATOR, dir / "Prog" / "Main.vm");
+  run(ASM_HACK, dir / "Prog" / "Main.asm");
+  BOOST_CHECK_EQUAL(result.asmCode, readFile(dir / "Prog" / "Main.asm"));
+  BOOST_CHECK_EQUAL(result.hack, readFile(dir / "Prog" / "Main.hack"));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_assemble, fixture) {
+  hcc::Source program = {"Loop.asm",
+    "// counts down from 5\n"
+    "@5\n"
+    "D=A\n"
+    "(LOOP)\n"
+    "  D=D-1\n"
+    "  @counter\n"
+    "  M=D\n"
+    "  @LOOP\n"
+    "  D;JGT\n"};
+  writeFile(dir / program.name, program.text);
+  hcc::Result result = hcc::assemble(program);
+  BOOST_CHECK(result.ok());
+  run(ASM_HACK, dir / program.name);
+  BOOST_CHECK_EQUAL(result.asmCode, program.text);
+  BOOST_CHECK_EQUAL(result.hack, readFile(dir / "Loop.hack"));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_malformed_class, fixture) {
+  vector<hcc::Source> withBad = classes;
+  withBad.insert(withBad.begin(), {"Bad.jack",
+    "class Bad {\n"
+    "  function void f() {\n"
+    "    let = 1;\n"
+    "  }\n"
+    "}\n"});
+  hcc::Result result = hcc::compileJack(withBad);
+  // the file it's in and the tool's message, without the newline.
+  checkDiagnostic(result, "Bad.jack", "Line 3, '=': Found unexpected token");
+  // the other classes still compile, stages after don't run.
+  BOOST_CHECK_EQUAL(result.vm.size(), 2);
+  BOOST_CHECK(result.asmCode.empty());
+  BOOST_CHECK(result.hack.empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(test_every_bad_class_reported, fixture) {
+  vector<hcc::Source> bad = {
+    {"A.jack", "class A { function void f() { let = 1; } }\n"},
+    {"B.jack", "class B {\n  function void f() {\n    do 1;\n"},
+  };
+  hcc::Result result = hcc::compileJack(bad);
+  BOOST_REQUIRE_EQUAL(result.diagnostics.size(), 2);
+  BOOST_CHECK_EQUAL(result.diagnostics[0].file, "A.jack");
+  BOOST_CHECK_EQUAL(result.diagnostics[1].file, "B.jack");
+  for (const hcc::Diagnostic &d: result.diagnostics) {
+    BOOST_CHECK(!d.message.empty());
+    BOOST_CHECK(d.message.back() != '\n');
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(test_malformed_vm_and_asm, fixture) {
+  hcc::Result result = hcc::translateVM({{"Bad.vm", "push nowhere 1\n"}});
+  checkDiagnostic(result, "Bad.vm", "Unknown instruction push nowhere 1");
+  BOOST_CHECK(result.asmCode.empty());
+
+  result = hcc::assemble({"Bad.asm", "@1\nD=Q\n"});
+  checkDiagnostic(result, "Bad.asm", "Error parsing line: 2");
+  BOOST_CHECK(result.hack.empty());
+}
+
+static bool sameResult(const hcc::Result &a, const hcc::Result &b) {
+  if (a.vm.size() != b.vm.size() || a.diagnostics.size() != b.diagnostics.size())
+    return false;
+  for (size_t i = 0; i < a.vm.size(); ++i)
+    if (a.vm[i].name != b.vm[i].name || a.vm[i].text != b.vm[i].text)
+      return false;
+  for (size_t i = 0; i < a.diagnostics.size(); ++i)
+    if (a.diagnostics[i].file != b.diagnostics[i].file ||
+        a.diagnostics[i].message != b.diagnostics[i].message)
+      return false;
+  return a.asmCode == b.asmCode && a.hack == b.hack;
+}
+
+BOOST_FIXTURE_TEST_CASE(test_calls_from_several_threads, fixture) {
+  // good and bad inputs, each checked against a single threaded call.
+  vector<hcc::Source> bad = {{"Bad.jack", "class Bad { function void f() { let = 1; } }\n"}};
+  hcc::Source loop = {"Loop.asm", "(LOOP)\n@i\nM=M+1\n@LOOP\n0;JMP\n"};
+  hcc::Source badAsm = {"Bad.asm", "@1\nD=Q\n"};
+  const hcc::Result expected[] = {
+    hcc::compileJack(classes),
+    hcc::compileJack(bad),
+    hcc::assemble(loop),
+    hcc::assemble(badAsm),
+  };
+  BOOST_REQUIRE(expected[0].ok() && expected[2].ok());
+
+  const int threads = 8;
+  const int rounds = 20;
+  vector<int> mismatches(threads);
+  vector<thread> workers;
+  for (int t = 0; t < threads; ++t)
+    workers.emplace_back([&, t] {
+      for (int r = 0; r < rounds; ++r) {
+        // threads start at different calls, so every pair overlaps.
+        switch ((t + r) % 4) {
+          case 0: mismatches[t] += !sameResult(hcc::compileJack(classes), expected[0]); break;
+          case 1: mismatches[t] += !sameResult(hcc::compileJack(bad), expected[1]); break;
+          case 2: mismatches[t] += !sameResult(hcc::assemble(loop), expected[2]); break;
+          case 3: mismatches[t] += !sameResult(hcc::assemble(badAsm), expected[3]); break;
+        }
+      }
+    });
+  for (thread &worker: workers)
+    worker.join();
+  for (int t = 0; t < threads; ++t)
+    BOOST_CHECK_EQUAL(mismatches[t], 0);
+}